@@ -50,15 +50,24 @@ if __name__ == '__main__':
     if choice == "rank":
         print("rank9...")
         run_bench("testrank9", "rank9", uniform=True)
+
+        print("rrr...")
+        run_bench("testrrr", "rrr_rank", uniform=True)
     elif choice == "select":
         print("rank9sel...")
         run_bench("testrank9sel", "select9", uniform=True)
 
         print("simple_select...")
         run_bench("testsimplesel3", "simple_select", uniform=True)
+
+        print("rrr...")
+        run_bench("testrrr", "rrr_select", uniform=True)
     elif choice == "select_non_uniform":
         print("rank9sel_non_uniform...")
         run_bench("testrank9sel", "select9_non_uniform", uniform=False)
 
         print("simple_select_non_uniform...")
         run_bench("testsimplesel3", "simple_select_non_uniform", uniform=False)
+
+        print("rrr_non_uniform...")
+        run_bench("testrrr", "rrr_select_non_uniform", uniform=False)
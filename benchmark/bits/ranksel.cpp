@@ -6,7 +6,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <sux/bits/EliasFano.hpp>
+#include <sux/bits/InterleavedRankSel.hpp>
 #include <sux/bits/Rank9Sel.hpp>
+#include <sux/bits/RRR.hpp>
+#include <sux/bits/RankSmall.hpp>
 #include <sux/bits/SimpleSelect.hpp>
 #include <sux/bits/SimpleSelectHalf.hpp>
 #include <thread>
@@ -56,6 +59,8 @@ void bench_rank(uint64_t num_bits, uint64_t repeats, uint64_t num_pos, double de
 	CLASS rs(bits, num_bits);
 #endif
 
+	printf("%f bits/bit\n", rs.bitCount() / (double)num_bits);
+
 #ifndef NORANKTEST
 	auto begin = chrono::high_resolution_clock::now();
 	for (int k = repeats; k-- != 0;) {
@@ -3,13 +3,18 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
+#include <sux/util/BAryPrefixSums.hpp>
 #include <sux/util/FenwickBitF.hpp>
 #include <sux/util/FenwickBitL.hpp>
 #include <sux/util/FenwickByteF.hpp>
 #include <sux/util/FenwickByteL.hpp>
 #include <sux/util/FenwickFixedF.hpp>
 #include <sux/util/FenwickFixedL.hpp>
+#include <sux/util/FenwickHybrid.hpp>
+#include <sux/util/StaticPrefixSums.hpp>
 
 #include "../../test/xoroshiro128pp.hpp"
 
@@ -44,12 +49,41 @@ template <template <size_t, AllocType> class FENWICK, size_t BOUND, AllocType AT
 	end = chrono::high_resolution_clock::now();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
 
+	// Batches of independent operations, with arguments generated in advance
+	constexpr size_t BATCH = 1024;
+	vector<size_t> idx(queries), out(queries);
+	vector<int64_t> inc(queries);
+	vector<uint64_t> val(queries);
+
+	for (size_t i = 0; i < queries; i++) idx[i] = 1 + next() % size;
+	cout << "prefixBatch: " << flush;
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < queries; i += BATCH) fenwick.prefixBatch(&idx[i], &val[i], min(BATCH, queries - i));
+	end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
+	for (size_t i = 0; i < queries; i++) u ^= val[i];
+
+	for (size_t i = 0; i < queries; i++) val[i] = next() % ((BOUND + 1) * size);
+	cout << "findBatch: " << flush;
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < queries; i += BATCH) fenwick.findBatch(&val[i], &out[i], min(BATCH, queries - i));
+	end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
+	for (size_t i = 0; i < queries; i++) u ^= out[i];
+
 	cout << "add: " << flush;
 	begin = chrono::high_resolution_clock::now();
 	for (size_t i = 0; i < queries; i++) fenwick.add(1 + (next() ^ (u & 1)) % size, next() % (BOUND + 1));
 	end = chrono::high_resolution_clock::now();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
 
+	for (size_t i = 0; i < queries; i++) inc[i] = next() % (BOUND + 1);
+	cout << "addBatch: " << flush;
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < queries; i += BATCH) fenwick.addBatch(&idx[i], &inc[i], min(BATCH, queries - i));
+	end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
+
 	cout << "space: " << fenwick.bitCount() / (double)size << " b/item\n";
 
 	// The add cannot be erased by the compiler
@@ -57,6 +91,65 @@ template <template <size_t, AllocType> class FENWICK, size_t BOUND, AllocType AT
 	const volatile uint64_t __attribute__((unused)) unused = u;
 }
 
+// Construction from a sequence with an increasing number of threads, and appends of large chunks
+template <template <size_t, AllocType> class FENWICK, size_t BOUND, AllocType AT> void runbuild(const char *name, size_t size) {
+	static constexpr size_t CHUNK = 1 << 20;
+	const int max_threads = max(1U, thread::hardware_concurrency());
+
+	cout << name << endl;
+	vector<uint64_t> sequence(size);
+	for (size_t i = 0; i < size; i++) sequence[i] = next() % (BOUND + 1);
+
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+		cout << "build (" << threads << " threads): " << flush;
+		auto begin = chrono::high_resolution_clock::now();
+		FENWICK<BOUND, AT> fenwick(sequence.data(), size, threads);
+		auto end = chrono::high_resolution_clock::now();
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / (double)size << " ns/item" << endl;
+	}
+
+	cout << "append: " << flush;
+	FENWICK<BOUND, AT> fenwick;
+	auto begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < size; i += CHUNK) fenwick.append(sequence.data() + i, min(CHUNK, size - i));
+	auto end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / (double)size << " ns/item" << endl;
+
+	const volatile uint64_t __attribute__((unused)) unused = fenwick.prefix(size);
+}
+
+// Static structures are built from a sequence, and updates rebuild them, so we do not measure pushes and additions
+template <template <size_t, AllocType> class SPS, size_t BOUND, AllocType AT> void runstatic(const char *name, size_t size, size_t queries) {
+	uint64_t u = 0;
+	const double c = 1. / queries;
+
+	cout << name << endl;
+	vector<uint64_t> sequence(size);
+	for (size_t i = 0; i < size; i++) sequence[i] = next() % (BOUND + 1);
+
+	cout << "build: " << flush;
+	auto begin = chrono::high_resolution_clock::now();
+	SPS<BOUND, AT> sps(sequence.data(), size);
+	auto end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / (double)size << " ns/item" << endl;
+
+	cout << "prefix: " << flush;
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < queries; ++i) u ^= sps.prefix(1 + (next() ^ (u & 1)) % size);
+	end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
+
+	cout << "find: " << flush;
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < queries; i++) u ^= sps.find((next() ^ (u & 1)) % ((BOUND + 1) * size));
+	end = chrono::high_resolution_clock::now();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() * c << " ns/item" << endl;
+
+	cout << "space: " << sps.bitCount() / (double)size << " b/item\n";
+
+	const volatile uint64_t __attribute__((unused)) unused = u;
+}
+
 int main(int argc, char **argv) {
 	if (argc != 3) {
 		cerr << "Not enough parameters: <size> <queries>\n";
@@ -87,6 +180,16 @@ int main(int argc, char **argv) {
 	runall<FenwickByteL, B, AT>("\nFenwickByteL", size, queries);
 	runall<FenwickBitF, B, AT>("\nFenwickBitF", size, queries);
 	runall<FenwickBitL, B, AT>("\nFenwickBitL", size, queries);
+	runall<FenwickHybridSplit<8>::type, B, AT>("\nFenwickHybrid (split 8)", size, queries);
+	runall<BAryPrefixSums, B, AT>("\nBAryPrefixSums", size, queries);
+	runstatic<StaticPrefixSums, B, AT>("\nStaticPrefixSums", size, queries);
+
+	runbuild<FenwickFixedF, B, AT>("\nFenwickFixedF", size);
+	runbuild<FenwickFixedL, B, AT>("\nFenwickFixedL", size);
+	runbuild<FenwickByteF, B, AT>("\nFenwickByteF", size);
+	runbuild<FenwickByteL, B, AT>("\nFenwickByteL", size);
+	runbuild<FenwickBitF, B, AT>("\nFenwickBitF", size);
+	runbuild<FenwickBitL, B, AT>("\nFenwickBitL", size);
 
 	return 0;
 }
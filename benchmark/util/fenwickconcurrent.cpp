@@ -0,0 +1,112 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sux/util/FenwickAtomicF.hpp>
+#include <sux/util/FenwickAtomicL.hpp>
+#include <sux/util/FenwickFixedF.hpp>
+
+#include "../../test/xoroshiro128pp.hpp"
+
+using namespace std;
+using namespace sux;
+using namespace sux::util;
+
+static constexpr size_t BOUND = 64;
+
+// next() is not thread safe, so each thread uses its own xorshift64* generator
+static uint64_t xorshift64star(uint64_t &state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * UINT64_C(2685821657736338717);
+}
+
+// A FenwickFixedF guarded by a mutex, as a baseline
+class LockedFenwick {
+	FenwickFixedF<BOUND> fenwick;
+	mutex lock;
+
+  public:
+	LockedFenwick(uint64_t sequence[], size_t size) : fenwick(sequence, size) {}
+
+	uint64_t prefix(size_t length) {
+		lock_guard<mutex> guard(lock);
+		return fenwick.prefix(length);
+	}
+
+	void add(size_t idx, int64_t inc) {
+		lock_guard<mutex> guard(lock);
+		fenwick.add(idx, inc);
+	}
+
+	size_t find(uint64_t val) {
+		lock_guard<mutex> guard(lock);
+		return fenwick.find(val);
+	}
+};
+
+// Each thread performs ops operations: one half additions, one quarter prefix sums and one quarter searches
+template <class FENWICK> void run(const char *name, vector<uint64_t> &sequence, size_t ops, int max_threads) {
+	const size_t size = sequence.size();
+	cout << name << endl;
+
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+		FENWICK fenwick(sequence.data(), size);
+		vector<thread> pool;
+		vector<uint64_t> result(threads);
+
+		auto begin = chrono::high_resolution_clock::now();
+		for (int t = 0; t < threads; t++) {
+			pool.emplace_back([&, t] {
+				uint64_t state = next() | 1, u = 0;
+				for (size_t i = 0; i < ops; i++) {
+					const uint64_t r = xorshift64star(state);
+					switch (r & 3) {
+					case 0:
+					case 1:
+						fenwick.add(1 + (r >> 2) % size, 1);
+						break;
+					case 2:
+						u ^= fenwick.prefix(1 + (r >> 2) % size);
+						break;
+					default:
+						u ^= fenwick.find((r >> 2) % ((BOUND + 1) * size));
+					}
+				}
+				result[t] = u;
+			});
+		}
+		for (auto &thread : pool) thread.join();
+		auto end = chrono::high_resolution_clock::now();
+
+		const double ns = chrono::duration_cast<chrono::nanoseconds>(end - begin).count();
+		cout << threads << " threads: " << threads * ops / ns * 1000 << " Mops/s" << endl;
+
+		const volatile uint64_t __attribute__((unused)) unused = result[0];
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		cerr << "Not enough parameters: <size> <ops per thread> <max threads>\n";
+		return -1;
+	}
+
+	const size_t size = stoul(argv[1]);
+	const size_t ops = stoul(argv[2]);
+	const int max_threads = stoi(argv[3]);
+
+	vector<uint64_t> sequence(size);
+	for (auto &x : sequence) x = next() % (BOUND / 2 + 1);
+
+	cout << "Performing " << ops << " operations per thread over " << size << " elements\n";
+
+	run<LockedFenwick>("\nFenwickFixedF with a mutex", sequence, ops, max_threads);
+	run<FenwickAtomicF<BOUND>>("\nFenwickAtomicF", sequence, ops, max_threads);
+	run<FenwickAtomicL<BOUND>>("\nFenwickAtomicL", sequence, ops, max_threads);
+
+	return 0;
+}
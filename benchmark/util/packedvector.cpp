@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sux/util/PackedVector.hpp>
+
+#include "../../test/xoroshiro128pp.hpp"
+
+using namespace std;
+using namespace sux;
+using namespace sux::util;
+
+int main(int argc, char **argv) {
+	if (argc < 4) {
+		fprintf(stderr, "Usage: %s <n> <width> <repeats>\n", argv[0]);
+		return 1;
+	}
+
+	const uint64_t n = strtoll(argv[1], NULL, 0);
+	const int width = atoi(argv[2]);
+	const uint64_t repeats = strtoll(argv[3], NULL, 0);
+	const uint64_t mask = width == 64 ? -1ULL : (UINT64_C(1) << width) - 1;
+
+	vector<uint64_t> values(n), out(n);
+	for (auto &v : values) v = next() & mask;
+	util::PackedVector<ALLOC_TYPE> pv(width, n);
+
+	auto begin = chrono::high_resolution_clock::now();
+	for (uint64_t r = 0; r < repeats; r++)
+		for (uint64_t i = 0; i < n; i++) pv.set(i, values[i]);
+	auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("set:    %f ns/element\n", elapsed / (double)(n * repeats));
+
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t r = 0; r < repeats; r++) pv.encode(0, values.data(), n);
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("encode: %f ns/element\n", elapsed / (double)(n * repeats));
+
+	uint64_t u = 0;
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t r = 0; r < repeats; r++) {
+		for (uint64_t i = 0; i < n; i++) out[i] = pv.get(i);
+		u ^= out[r % n];
+	}
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("get:    %f ns/element\n", elapsed / (double)(n * repeats));
+
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t r = 0; r < repeats; r++) {
+		pv.decode(0, n, out.data());
+		u ^= out[r % n];
+	}
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("decode: %f ns/element\n", elapsed / (double)(n * repeats));
+
+	const volatile uint64_t __attribute__((unused)) unused = u;
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sux/bits/EliasFano.hpp>
+#include <sux/util/RiceSequence.hpp>
+
+#include "../../test/xoroshiro128pp.hpp"
+
+using namespace std;
+using namespace sux;
+using namespace sux::util;
+
+int main(int argc, char **argv) {
+	if (argc < 4) {
+		fprintf(stderr, "Usage: %s <n> <average gap> <queries>\n", argv[0]);
+		return 1;
+	}
+
+	const uint64_t n = strtoll(argv[1], NULL, 0);
+	const uint64_t avg_gap = strtoll(argv[2], NULL, 0);
+	const uint64_t queries = strtoll(argv[3], NULL, 0);
+
+	// Geometrically distributed gaps (plus one) with the given average
+	const double p = 1. / avg_gap;
+	vector<uint64_t> values(n);
+	for (uint64_t i = 0, v = 0; i < n; i++) values[i] = v += 1 + (uint64_t)(log((next() >> 11) * 0x1.0p-53) / log1p(-p));
+
+	util::RiceSequence<ALLOC_TYPE> rs(values);
+	bits::EliasFano<ALLOC_TYPE> ef(values, values[n - 1] + 1);
+
+	printf("RiceSequence (log2golomb = %d): %f bits/element\n", rs.getLog2Golomb(), rs.bitCount() / (double)n);
+	printf("EliasFano:                      %f bits/element\n", ef.bitCount() / (double)n);
+
+	uint64_t u = 0;
+	auto begin = chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < queries; i++) u ^= rs.get(remap128(next() ^ (u & 1), n));
+	auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("RiceSequence get:     %f ns/element\n", elapsed / (double)queries);
+
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < queries; i++) u ^= ef.select(remap128(next() ^ (u & 1), n));
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("EliasFano select:     %f ns/element\n", elapsed / (double)queries);
+
+	begin = chrono::high_resolution_clock::now();
+	for (auto it = rs.iterator(); it.hasNext();) u ^= it.next();
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("RiceSequence scan:    %f ns/element\n", elapsed / (double)n);
+
+	begin = chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < n; i++) u ^= ef.select(i);
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - begin).count();
+	printf("EliasFano scan:       %f ns/element\n", elapsed / (double)n);
+
+	const volatile uint64_t __attribute__((unused)) unused = u;
+	return 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "../util/Vector.hpp"
+#include "Rank9Sel.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace sux::bits {
+
+using namespace std;
+using namespace sux;
+
+/** A balanced sequence of parentheses supporting matching and enclosing, and the navigation of the ordinal tree it represents.
+ *
+ * Open parentheses are represented by ones, and closed parentheses by zeros. The _excess_ at a position
+ * is the number of open minus the number of closed parentheses up to the position (included).
+ * All operations reduce to searching forward or backward for the nearest position with a given
+ * excess, which is performed first within the block of 1024 bits containing the starting position,
+ * then using a range min-max tree (which stores the minimum excess of each block, and of each
+ * subtree of blocks) to locate the block containing the answer, which is finally scanned.
+ *
+ * Words are scanned broadword: the excess before each byte of a word is computed in parallel, and
+ * a parallel comparison on bytes finds the first byte that might contain the answer; candidate bytes
+ * are then examined using precomputed tables. Backward searches scan words with reversed and
+ * complemented bits using the same code.
+ *
+ * Ranking and selection (i.e., preorder numbering of nodes) use Rank9Sel. Besides the bit vector,
+ * the structure uses about 69% additional space (Rank9Sel, plus 12.5% for the range min-max tree).
+ *
+ * The bit vector provided at construction time is copied.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class BalancedParentheses {
+  private:
+	static constexpr int log2_bits_per_block = 10;
+
+	// For each byte, the minimum excess of a nonempty prefix and, for each d from 1 to 8,
+	// the length minus one of the shortest prefix with excess -d (8 if there is no such prefix).
+	struct ByteTables {
+		int8_t min[256];
+		uint8_t reach[8][256];
+	};
+
+	static constexpr ByteTables make_byte_tables() {
+		ByteTables t{};
+		for (int byte = 0; byte < 256; byte++) {
+			int e = 0, min = 8;
+			for (int d = 0; d < 8; d++) t.reach[d][byte] = 8;
+			for (int b = 0; b < 8; b++) {
+				e += byte >> b & 1 ? 1 : -1;
+				min = std::min(min, e);
+				if (e < 0 && t.reach[-e - 1][byte] == 8) t.reach[-e - 1][byte] = b;
+			}
+			t.min[byte] = min;
+		}
+		return t;
+	}
+
+	static constexpr ByteTables tables = make_byte_tables();
+
+	size_t num_bits;
+	util::Vector<uint64_t, AT> bits;
+	Rank9Sel<AT> rank_select;
+	// A complete binary tree (root at 1, leaves from num_leaves) containing the minimum excess of each subtree of blocks.
+	util::Vector<int64_t, AT> min_excess;
+	uint64_t num_leaves;
+
+	__inline static uint64_t reverse(uint64_t x) {
+		x = (x >> 1 & 0x5 * ONES_STEP_4) | (x & 0x5 * ONES_STEP_4) << 1;
+		x = (x >> 2 & 0x3 * ONES_STEP_4) | (x & 0x3 * ONES_STEP_4) << 2;
+		x = (x >> 4 & 0xF * ONES_STEP_8) | (x & 0xF * ONES_STEP_8) << 4;
+		return __builtin_bswap64(x);
+	}
+
+	// Returns the first p < nbits such that the excess of bits 0..p of w is at most d (which must be negative),
+	// or -1; in the latter case, d is decreased by the excess of the first nbits bits of w.
+	static int fwd_word(const uint64_t w, const int nbits, int64_t &d) {
+		if (d >= -nbits) {
+			// The number of ones before each byte
+			uint64_t s = w - ((w & 0xA * ONES_STEP_4) >> 1);
+			s = (s & 0x3 * ONES_STEP_4) + ((s >> 2) & 0x3 * ONES_STEP_4);
+			s = (s + (s >> 4)) & 0xF * ONES_STEP_8;
+			const uint64_t before = (s * ONES_STEP_8) << 8;
+			// Byte b is a candidate if its excess (2 before_b - 8b) minus 8 is at most d. Both
+			// sides are increased by 64, so the comparison can be performed in parallel on bytes.
+			const uint64_t x = 2 * before + UINT64_C(0x0008101820283038), y = (d + 64) * ONES_STEP_8;
+			for (uint64_t candidates = ((y | MSBS_STEP_8) - x) & MSBS_STEP_8; candidates != 0; candidates &= candidates - 1) {
+				const int b = rho(candidates) / 8;
+				const int64_t db = d - (2 * int64_t(before >> 8 * b & 0xFF) - 8 * b);
+				const uint8_t byte = w >> 8 * b;
+				if (tables.min[byte] <= db) {
+					const int p = 8 * b + tables.reach[-db - 1][byte];
+					if (p < nbits) return p;
+					break;
+				}
+			}
+		}
+		d -= 2 * nu(nbits == 64 ? w : w & ((UINT64_C(1) << nbits) - 1)) - nbits;
+		return -1;
+	}
+
+	// Returns the first position p in [from..to) such that the excess of positions from..p is at
+	// most d (which must be negative), or to; in the latter case, d is decreased by the excess of [from..to).
+	uint64_t scan_fwd(uint64_t from, const uint64_t to, int64_t &d) const {
+		while (from < to) {
+			const int nbits = std::min(uint64_t(64 - from % 64), to - from);
+			const int p = fwd_word(bits[from / 64] >> from % 64, nbits, d);
+			if (p >= 0) return from + p;
+			from += nbits;
+		}
+		return to;
+	}
+
+	// Returns the largest k in [lo..hi) such that the excess of positions k+1..hi, negated, is at most d
+	// (which must be negative), or lo - 1; in the latter case, d is updated as in scan_fwd().
+	int64_t scan_bwd(int64_t hi, const int64_t lo, int64_t &d) const {
+		while (hi > lo) {
+			const int b = hi % 64;
+			const int nbits = std::min(int64_t(b + 1), hi - lo);
+			const int p = fwd_word(reverse(~bits[hi / 64]) >> (63 - b), nbits, d);
+			if (p >= 0) return hi - p - 1;
+			hi -= nbits;
+		}
+		return lo - 1;
+	}
+
+	__inline uint64_t block_end(const uint64_t block) const { return std::min(num_bits, (block + 1) << log2_bits_per_block); }
+
+	// Returns the smallest j > i such that excess(j) <= target, given target < excess(i), or num_bits.
+	uint64_t fwd_search(const uint64_t i, const int64_t target) {
+		int64_t d = target - excess(i);
+		const uint64_t block = i >> log2_bits_per_block;
+		uint64_t j = scan_fwd(i + 1, block_end(block), d);
+		if (j < block_end(block)) return j;
+
+		for (uint64_t node = num_leaves + block; node > 1; node >>= 1) {
+			if ((node & 1) == 0 && min_excess[node + 1] <= target) {
+				node++;
+				while (node < num_leaves) node = min_excess[2 * node] <= target ? 2 * node : 2 * node + 1;
+				const uint64_t start = (node - num_leaves) << log2_bits_per_block;
+				d = target - excess(start - 1);
+				j = scan_fwd(start, block_end(node - num_leaves), d);
+				assert(j < block_end(node - num_leaves));
+				return j;
+			}
+		}
+
+		return num_bits;
+	}
+
+	// Returns the largest k < i such that excess(k) <= target, or -1 (excess(-1) is zero).
+	int64_t bwd_search(const uint64_t i, const int64_t target) {
+		if (i == 0) return -1;
+		int64_t e = excess(i - 1);
+		if (e <= target) return i - 1;
+		int64_t d = target - e;
+		const uint64_t block = (i - 1) >> log2_bits_per_block;
+		int64_t k = scan_bwd(i - 1, block << log2_bits_per_block, d);
+		if (k >= int64_t(block << log2_bits_per_block)) return k;
+
+		for (uint64_t node = num_leaves + block; node > 1; node >>= 1) {
+			if ((node & 1) == 1 && min_excess[node - 1] <= target) {
+				node--;
+				while (node < num_leaves) node = min_excess[2 * node + 1] <= target ? 2 * node + 1 : 2 * node;
+				const int64_t start = (node - num_leaves) << log2_bits_per_block, last = block_end(node - num_leaves) - 1;
+				e = excess(last);
+				if (e <= target) return last;
+				d = target - e;
+				k = scan_bwd(last, start, d);
+				assert(k >= start);
+				return k;
+			}
+		}
+
+		return -1;
+	}
+
+  public:
+	BalancedParentheses() {}
+
+	/** Creates a new instance using a given bit vector.
+	 *
+	 * The content of the bit vector is copied.
+	 *
+	 * @param bits a bit vector of 64-bit words representing a balanced sequence of parentheses (ones are open parentheses).
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	BalancedParentheses(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits) {
+		const uint64_t num_words = (num_bits + 63) / 64;
+		// A free word makes rank(num_bits) possible
+		this->bits.size(num_words + 1);
+		std::copy(bits, bits + num_words, &this->bits);
+		if (num_bits % 64 != 0) this->bits[num_words - 1] &= (UINT64_C(1) << num_bits % 64) - 1;
+		rank_select = Rank9Sel<AT>(&this->bits, num_bits);
+
+		const uint64_t num_blocks = (num_bits + (1 << log2_bits_per_block) - 1) >> log2_bits_per_block;
+		num_leaves = 1;
+		while (num_leaves < num_blocks) num_leaves *= 2;
+		min_excess.size(2 * num_leaves);
+		for (uint64_t i = num_leaves; i < 2 * num_leaves; i++) min_excess[i] = INT64_MAX;
+
+		int64_t e = 0;
+		for (uint64_t w = 0; w < num_words; w++) {
+			const uint64_t block = w >> (log2_bits_per_block - 6);
+			int64_t &m = min_excess[num_leaves + block];
+			// Bits past the end are set, so they do not lower the minimum
+			const uint64_t word = w == num_words - 1 && num_bits % 64 != 0 ? this->bits[w] | -(UINT64_C(1) << num_bits % 64) : this->bits[w];
+			for (int b = 0; b < 64; b += 8) {
+				const uint8_t byte = word >> b;
+				m = std::min(m, e + tables.min[byte]);
+				e += 2 * nu(byte) - 8;
+			}
+		}
+		for (uint64_t i = num_leaves; i-- > 1;) min_excess[i] = std::min(min_excess[2 * i], min_excess[2 * i + 1]);
+	}
+
+	/** Returns whether there is an open parenthesis at a given position. */
+	bool isOpen(const uint64_t i) const { return bits[i / 64] >> i % 64 & 1; }
+
+	/** Returns the excess at a given position.
+	 *
+	 * @param i a position, or &minus;1.
+	 * @return the number of open minus the number of closed parentheses up to position `i` (included).
+	 */
+	int64_t excess(const int64_t i) { return 2 * int64_t(rank_select.rank(i + 1)) - (i + 1); }
+
+	/** Returns the position of the parenthesis matching a given open parenthesis.
+	 *
+	 * @param i the position of an open parenthesis.
+	 */
+	uint64_t findClose(const uint64_t i) {
+		assert(isOpen(i));
+		return fwd_search(i, excess(i) - 1);
+	}
+
+	/** Returns the position of the parenthesis matching a given closed parenthesis.
+	 *
+	 * @param i the position of a closed parenthesis.
+	 */
+	uint64_t findOpen(const uint64_t i) {
+		assert(!isOpen(i));
+		return bwd_search(i, excess(i)) + 1;
+	}
+
+	/** Returns the position of the open parenthesis of the nearest pair enclosing a given open parenthesis.
+	 *
+	 * @param i the position of an open parenthesis.
+	 * @return the position of the open parenthesis of the nearest pair enclosing the pair
+	 * opened at `i`, or size() if there is no such pair.
+	 */
+	uint64_t enclose(const uint64_t i) {
+		assert(isOpen(i));
+		const int64_t e = excess(i);
+		if (e == 1) return num_bits;
+		return bwd_search(i, e - 2) + 1;
+	}
+
+	/** Returns the parent of a node (represented by the position of its open parenthesis), or size() if the node is a root. */
+	uint64_t parent(const uint64_t v) { return enclose(v); }
+
+	/** Returns the first child of a node, or size() if the node is a leaf. */
+	uint64_t firstChild(const uint64_t v) { return v + 1 < num_bits && isOpen(v + 1) ? v + 1 : num_bits; }
+
+	/** Returns the next sibling of a node, or size() if the node is the last child of its parent. */
+	uint64_t nextSibling(const uint64_t v) {
+		const uint64_t c = findClose(v) + 1;
+		return c < num_bits && isOpen(c) ? c : num_bits;
+	}
+
+	/** Returns whether a node is a leaf. */
+	bool isLeaf(const uint64_t v) const { return !isOpen(v + 1); }
+
+	/** Returns the number of nodes in the subtree of a node (including the node itself). */
+	uint64_t subtreeSize(const uint64_t v) { return (findClose(v) - v + 1) / 2; }
+
+	/** Returns the depth of a node (roots have depth one). */
+	uint64_t depth(const uint64_t v) { return excess(v); }
+
+	/** Returns the index of a node in preorder. */
+	uint64_t preorder(const uint64_t v) { return rank_select.rank(v); }
+
+	/** Returns the node of given index in preorder. */
+	uint64_t node(const uint64_t k) { return rank_select.select(k); }
+
+	/** Returns the number of nodes. */
+	uint64_t numNodes() { return rank_select.rank(num_bits); }
+
+	/** Returns the length in bits of the sequence of parentheses. */
+	size_t size() const { return num_bits; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const {
+		return bits.bitCount() - sizeof(bits) * 8 + rank_select.bitCount() - sizeof(rank_select) * 8 + min_excess.bitCount() - sizeof(min_excess) * 8 + sizeof(*this) * 8;
+	}
+};
+
+} // namespace sux::bits
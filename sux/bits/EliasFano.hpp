@@ -28,9 +28,12 @@
 
 #pragma once
 
+#include "../support/parallel.hpp"
+#include "../util/Mapping.hpp"
 #include "Rank.hpp"
 #include "SimpleSelectHalf.hpp"
 #include "SimpleSelectZeroHalf.hpp"
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
@@ -46,6 +49,9 @@ using namespace sux;
  * positions for the ones in a vector. In every case, the bit vector or the list
  * are not necessary after construction.
  *
+ * Instances can be serialized with the `<<` and `>>` operators, and a read-only
+ * view of a serialized instance can be created without copying from a util::Mapping.
+ *
  * @tparam AT a type of memory allocation out of sux::util::AllocType.
  */
 
@@ -91,19 +97,84 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 		}
 	}
 
+	// Computes the parameters of the blocks of lower bits from l
+	void init_blocks() {
+		block_size = 0;
+		do ++block_size;
+		while (block_size * l + block_size <= 64 && block_size <= l);
+		block_size--;
+
+#ifdef DEBUG
+		printf("Block size: %d\n", block_size);
+#endif
+
+		block_size_mask = (1ULL << block_size) - 1;
+		block_length = block_size * l;
+
+#ifdef PARSEARCH
+		ones_step_l = 0;
+		for (int i = 0; i < block_size; i++) ones_step_l |= 1ULL << i * l;
+		msbs_step_l = ones_step_l << (l - 1);
+
+		compressor = 0;
+		for (int i = 0; i < block_size; i++) compressor |= 1ULL << ((l - 1) * i + block_size);
+#endif
+
+		lower_l_bits_mask = (1ULL << l) - 1;
+	}
+
+	void save(std::ostream &os) const {
+		util::save(os, num_bits);
+		util::save(os, num_ones);
+		util::save(os, l);
+		util::save(os, lower_bits);
+		util::save(os, upper_bits);
+		select_upper.save_index(os);
+		selectz_upper.save_index(os);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, num_bits);
+		util::load(src, num_ones);
+		util::load(src, l);
+		util::load(src, lower_bits);
+		util::load(src, upper_bits);
+		select_upper.load_index(src, &upper_bits);
+		selectz_upper.load_index(src, &upper_bits);
+		init_blocks();
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const EliasFano<AT> &ef) {
+		ef.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, EliasFano<AT> &ef) {
+		ef.load(is);
+		return is;
+	}
+
   public:
+	EliasFano() {}
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit EliasFano(util::Mapping &mapping) { load(mapping); }
+
 	/** Creates a new instance using a given bit vector.
 	 *
 	 * Note that the bit vector is read only at construction time.
 	 *
 	 * @param bits a bit vector of 64-bit words.
 	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
 	 */
-	EliasFano(const uint64_t *const bits, const uint64_t num_bits) {
+	EliasFano(const uint64_t *const bits, const uint64_t num_bits, const int threads = 1) {
 		const uint64_t num_words = (num_bits + 63) / 64;
-		uint64_t m = 0;
-		for (uint64_t i = num_words; i-- != 0;) m += __builtin_popcountll(bits[i]);
-		num_ones = m;
+		const vector<uint64_t> slice_rank = slice_ranks(bits, num_bits, threads);
+		num_ones = slice_rank[threads];
 		this->num_bits = num_bits;
 		l = num_ones == 0 ? 0 : max(0, lambda_safe(num_bits / num_ones));
 
@@ -115,17 +186,30 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 
 		const uint64_t lower_bits_mask = (1ULL << l) - 1;
 
-		lower_bits.size((num_ones * l + 63) / 64 + 2 * (l == 0));
+		// A padding word makes branchless reads by Iterator possible
+		lower_bits.size((num_ones * l + 63) / 64 + 1 + (l == 0));
 		upper_bits.size(((num_ones + (num_bits >> l) + 1) + 63) / 64);
 
-		uint64_t pos = 0;
-		for (uint64_t i = 0; i < num_bits; i++) {
-			if (bits[i / 64] & (1ULL << i % 64)) {
-				if (l != 0) set_bits(lower_bits, pos * l, l, i & lower_bits_mask);
-				set(upper_bits, (i >> l) + pos);
-				pos++;
+		// The ones at distance less than 64 from the ends of a slice might share words of the lower
+		// or upper bits with the ones of other slices, so they are stored sequentially at the end
+		vector<vector<pair<uint64_t, uint64_t>>> deferred(threads);
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones(bits, num_bits, from, to, slice_rank[t], slice_rank[t], [&](const uint64_t d, const uint64_t pos) {
+				if (threads > 1 && (d < slice_rank[t] + 64 || d + 64 >= slice_rank[t + 1]))
+					deferred[t].emplace_back(d, pos);
+				else {
+					if (l != 0) set_bits(lower_bits, d * l, l, pos & lower_bits_mask);
+					set(upper_bits, (pos >> l) + d);
+				}
+				return d + 1;
+			});
+		});
+
+		for (const auto &slice : deferred)
+			for (const auto &[d, pos] : slice) {
+				if (l != 0) set_bits(lower_bits, d * l, l, pos & lower_bits_mask);
+				set(upper_bits, (pos >> l) + d);
 			}
-		}
 
 #ifdef DEBUG
 		// printf("First lower: %016llx %016llx %016llx %016llx\n", lower_bits[0], lower_bits[1],
@@ -134,31 +218,10 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 		//       upper_bits[2], upper_bits[3]);
 #endif
 
-		select_upper = SimpleSelectHalf(&upper_bits, num_ones + (num_bits >> l) + 1);
-		selectz_upper = SimpleSelectZeroHalf(&upper_bits, num_ones + (num_bits >> l) + 1);
-
-		block_size = 0;
-		do ++block_size;
-		while (block_size * l + block_size <= 64 && block_size <= l);
-		block_size--;
-
-#ifdef DEBUG
-		printf("Block size: %d\n", block_size);
-#endif
-
-		block_size_mask = (1ULL << block_size) - 1;
-		block_length = block_size * l;
-
-#ifdef PARSEARCH
-		ones_step_l = 0;
-		for (int i = 0; i < block_size; i++) ones_step_l |= 1ULL << i * l;
-		msbs_step_l = ones_step_l << (l - 1);
+		select_upper = SimpleSelectHalf<AT>(&upper_bits, num_ones + (num_bits >> l) + 1, threads);
+		selectz_upper = SimpleSelectZeroHalf<AT>(&upper_bits, num_ones + (num_bits >> l) + 1, threads);
 
-		compressor = 0;
-		for (int i = 0; i < block_size; i++) compressor |= 1ULL << ((l - 1) * i + block_size);
-#endif
-
-		lower_l_bits_mask = (1ULL << l) - 1;
+		init_blocks();
 	}
 
 	/** Creates a new instance using an
@@ -187,7 +250,8 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 
 		const uint64_t lower_bits_mask = (1ULL << l) - 1;
 
-		lower_bits.size((num_ones * l + 63) / 64 + 2 * (l == 0));
+		// A padding word makes branchless reads by Iterator possible
+		lower_bits.size((num_ones * l + 63) / 64 + 1 + (l == 0));
 		upper_bits.size(((num_ones + (num_bits >> l) + 1) + 63) / 64);
 
 		for (uint64_t i = 0; i < num_ones; i++) {
@@ -200,30 +264,10 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 		printf("First upper: %016llx %016llx %016llx %016llx\n", upper_bits[0], upper_bits[1], upper_bits[2], upper_bits[3]);
 #endif
 
-		select_upper = SimpleSelectHalf(&upper_bits, num_ones + (num_bits >> l) + 1);
-		selectz_upper = SimpleSelectZeroHalf(&upper_bits, num_ones + (num_bits >> l) + 1);
-
-		block_size = 0;
-		do ++block_size;
-		while (block_size * l + block_size <= 64 && block_size <= l);
-		block_size--;
-
-#ifdef DEBUG
-		printf("Block size: %d\n", block_size);
-#endif
-		block_size_mask = (1ULL << block_size) - 1;
-		block_length = block_size * l;
-
-#ifdef PARSEARCH
-		ones_step_l = 0;
-		for (int i = 0; i < block_size; i++) ones_step_l |= 1ULL << i * l;
-		msbs_step_l = ones_step_l << (l - 1);
-
-		compressor = 0;
-		for (int i = 0; i < block_size; i++) compressor |= 1ULL << ((l - 1) * i + block_size);
-#endif
+		select_upper = SimpleSelectHalf<AT>(&upper_bits, num_ones + (num_bits >> l) + 1);
+		selectz_upper = SimpleSelectZeroHalf<AT>(&upper_bits, num_ones + (num_bits >> l) + 1);
 
-		lower_l_bits_mask = (1ULL << l) - 1;
+		init_blocks();
 	}
 
 	uint64_t rank(const size_t k) {
@@ -339,11 +383,132 @@ template <util::AllocType AT = util::AllocType::MALLOC> class EliasFano : public
 		return s << l | get_bits(lower_bits, position, l);
 	}
 
+	/** Computes the ranks of a batch of positions.
+	 *
+	 * Positions are processed in windows of ::BATCH_WINDOW queries, in stages: first the inventories
+	 * of the upper bits needed by all queries in a window are prefetched, then the words of
+	 * the upper bits where the search starts, and finally the queries are answered, so that the cache
+	 * misses of independent queries overlap.
+	 *
+	 * @param pos an array of `n` positions.
+	 * @param out an array of `n` elements that will contain the ranks of the positions in `pos`.
+	 * @param n the number of positions.
+	 */
+	void rank(const uint64_t *const pos, uint64_t *const out, const size_t n) {
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t e = std::min(n, b + BATCH_WINDOW);
+			if (num_ones != 0) {
+				for (size_t i = b; i < e; i++)
+					if (pos[i] < num_bits) selectz_upper.prefetchInventory(pos[i] >> l);
+				for (size_t i = b; i < e; i++)
+					if (pos[i] < num_bits) selectz_upper.prefetchWord(pos[i] >> l);
+			}
+			for (size_t i = b; i < e; i++) out[i] = rank(pos[i]);
+		}
+	}
+
+	/** Computes the positions of the ones of a batch of ranks.
+	 *
+	 * Ranks are processed in windows of ::BATCH_WINDOW queries, in stages: first the inventories
+	 * of the upper bits and the lower bits needed by all queries in a window are prefetched, then the words of
+	 * the upper bits where the search starts, and finally the queries are answered, so that the cache
+	 * misses of independent queries overlap.
+	 *
+	 * @param rank an array of `n` ranks.
+	 * @param out an array of `n` elements that will contain the positions of the ones of given ranks.
+	 * @param n the number of ranks.
+	 */
+	void select(const uint64_t *const rank, uint64_t *const out, const size_t n) {
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t e = std::min(n, b + BATCH_WINDOW);
+			for (size_t i = b; i < e; i++) {
+				select_upper.prefetchInventory(rank[i]);
+				__builtin_prefetch(&lower_bits + rank[i] * l / 64);
+			}
+			for (size_t i = b; i < e; i++) select_upper.prefetchWord(rank[i]);
+			for (size_t i = b; i < e; i++) out[i] = select(rank[i]);
+		}
+	}
+
+	/** An iterator returning the positions of the ones in increasing order.
+	 *
+	 * Positions are decoded by scanning the upper bits word by word,
+	 * which is much faster than calling select() for every index.
+	 */
+	class Iterator {
+		EliasFano<AT> &ef;
+		uint64_t index, word, window;
+
+		// Moves to the given position in the upper bits, which must contain the one of index `index`.
+		void position(const uint64_t upper_pos) {
+			word = upper_pos / 64;
+			window = ef.upper_bits[word] & -1ULL << upper_pos % 64;
+		}
+
+	  public:
+		Iterator(EliasFano<AT> &ef, const uint64_t from) : ef(ef), index(min(from, ef.num_ones)), word(0), window(0) {
+			if (index < ef.num_ones) position(ef.select_upper.select(index));
+		}
+
+		/** Returns whether there are more positions to return. */
+		bool hasNext() const { return index < ef.num_ones; }
+
+		/** Returns the rank of the position that will be returned by next(). */
+		uint64_t nextIndex() const { return index; }
+
+		/** Returns the next position. */
+		uint64_t next() {
+			assert(hasNext());
+			while (window == 0) window = ef.upper_bits[++word];
+			const uint64_t upper = word * 64 + rho(window) - index;
+			window &= window - 1;
+			const uint64_t lower_pos = index++ * ef.l;
+			const uint64_t *const lower = &ef.lower_bits + lower_pos / 64;
+			return upper << ef.l | ((lower[0] >> lower_pos % 64 | lower[1] << 1 << (63 - lower_pos % 64)) & ef.lower_l_bits_mask);
+		}
+
+		/** Skips to the first position greater than or equal to a given bound and returns it.
+		 *
+		 * If the bound is far ahead, the scan restarts from the bucket of the
+		 * bound, which is located using the zero selection structure on the upper bits.
+		 *
+		 * @param x a bound.
+		 * @return the first position greater than or equal to `x` following the last returned
+		 * position, or size() if no such position exists (in which case hasNext() becomes false).
+		 */
+		uint64_t nextGEQ(const uint64_t x) {
+			if (x >= ef.num_bits) index = ef.num_ones;
+			if (!hasNext()) return ef.num_bits;
+
+			const uint64_t high = x >> ef.l;
+			while (window == 0) window = ef.upper_bits[++word];
+			if (high > word * 64 + rho(window) - index) {
+				// The first element with upper bits at least high follows the (high - 1)-th zero
+				const uint64_t upper_pos = ef.selectz_upper.selectZero(high - 1) + 1;
+				index = upper_pos - high;
+				if (!hasNext()) return ef.num_bits;
+				position(upper_pos);
+			}
+
+			while (hasNext()) {
+				const uint64_t v = next();
+				if (v >= x) return v;
+			}
+			return ef.num_bits;
+		}
+	};
+
+	/** Returns an iterator starting at a given rank.
+	 *
+	 * @param from the rank of the first position returned by the iterator.
+	 */
+	Iterator iterator(const uint64_t from = 0) { return Iterator(*this, from); }
+
 	/** Returns the size in bits of the underlying bit vector. */
 	size_t size() const { return num_bits; }
 
 	/** Returns an estimate of the size in bits of this structure. */
-	uint64_t bitCount() {
+	uint64_t bitCount() const {
 		return upper_bits.bitCount() - sizeof(upper_bits) * 8 + lower_bits.bitCount() - sizeof(lower_bits) * 8 + select_upper.bitCount() - sizeof(select_upper) * 8 + selectz_upper.bitCount() -
 			   sizeof(selectz_upper) * 8 + sizeof(*this) * 8;
 	}
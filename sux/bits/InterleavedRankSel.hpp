@@ -0,0 +1,235 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2020 Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "../util/Mapping.hpp"
+#include "../util/Vector.hpp"
+#include "Rank.hpp"
+#include "Select.hpp"
+#include <cstdint>
+
+namespace sux::bits {
+
+using namespace sux;
+
+/** A ranking and selection structure interleaving counts and bits in cache lines.
+ *
+ * The bit vector is copied into lines of 512 bits, aligned to cache lines, each containing
+ * a header word followed by seven words of the bit vector. The header contains the number of
+ * ones before the line (relative to a superblock of 2<sup>24</sup> lines, whose absolute
+ * counts are stored in a separate, tiny array) in its upper 37 bits, and the number of
+ * ones before the third, fifth and seventh word of the line relative to the start of
+ * the line in three 9-bit fields. Thus, ranking causes a single cache miss, versus the
+ * two misses of Rank9 (one for the counts and one for the bit vector), at the price of
+ * 14.3% additional space.
+ *
+ * Selection samples the index of the line containing one every 2<sup>9</sup> ones
+ * (up to 12.5% additional space, depending on density); the line containing a one
+ * is then located by a scan or by a binary search on the headers, and the relevant
+ * word using the subcounts.
+ *
+ * Since the bits are copied, the bit vector provided at construction time can be discarded
+ * afterwards.
+ *
+ * Serialization and views work as in Rank9. Views are as fast as ordinary instances
+ * if the file was written sequentially, so that the lines are aligned to cache lines.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class InterleavedRankSel : public Rank, public Select {
+  private:
+	static constexpr int bits_per_line = 7 * 64;
+	static constexpr int log2_lines_per_superblock = 24;
+	static constexpr int log2_ones_per_sample = 9;
+	// Beyond this number of lines, selection uses binary instead of linear search
+	static constexpr uint64_t max_linear_span = 16;
+
+	size_t num_bits, num_ones, num_lines;
+	util::Vector<uint64_t, AT> storage, superblocks, samples;
+	// The first cache-line-aligned word of storage (moving storage does not change it)
+	uint64_t *lines = nullptr;
+
+	__inline uint64_t count(const uint64_t line) const { return superblocks[line >> log2_lines_per_superblock] + (lines[line * 8] >> 27); }
+
+	// The lines are preceded by padding that aligns them to a cache line within the stream (if
+	// its position is known), so that they are aligned also in a mapping of the stream.
+	void save(std::ostream &os) const {
+		util::save(os, num_bits);
+		util::save(os, num_ones);
+		util::save(os, num_lines);
+		util::save(os, superblocks);
+		util::save(os, samples);
+		const std::streamoff p = os.tellp();
+		const uint64_t pad = p == -1 ? 0 : (64 - (p + 8) % 64) % 64 / 8, zero = 0;
+		util::save(os, pad);
+		for (uint64_t i = 0; i < pad; i++) os.write((char *)&zero, sizeof zero);
+		os.write((char *)lines, num_lines * 8 * sizeof(uint64_t));
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, num_bits);
+		util::load(src, num_ones);
+		util::load(src, num_lines);
+		util::load(src, superblocks);
+		util::load(src, samples);
+		uint64_t pad;
+		util::load(src, pad);
+		load_lines(src, pad);
+	}
+
+	void load_lines(std::istream &is, const uint64_t pad) {
+		is.ignore(pad * sizeof(uint64_t));
+		storage.size(num_lines * 8 + 7);
+		lines = &storage + ((64 - ((uintptr_t)&storage & 63)) & 63) / 8;
+		is.read((char *)lines, num_lines * 8 * sizeof(uint64_t));
+	}
+
+	void load_lines(util::Mapping &mapping, const uint64_t pad) {
+		mapping.next(pad);
+		storage = util::Vector<uint64_t, AT>();
+		lines = const_cast<uint64_t *>(mapping.next(num_lines * 8));
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const InterleavedRankSel<AT> &rs) {
+		rs.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, InterleavedRankSel<AT> &rs) {
+		rs.load(is);
+		return is;
+	}
+
+  public:
+	InterleavedRankSel() {}
+
+	/** Creates a new instance using a given bit vector.
+	 *
+	 * The content of the bit vector is copied.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	InterleavedRankSel(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits) {
+		const uint64_t num_words = (num_bits + 63) / 64;
+		num_lines = num_bits / bits_per_line + 1;
+
+		storage.size(num_lines * 8 + 7);
+		lines = &storage + ((64 - ((uintptr_t)&storage & 63)) & 63) / 8;
+		superblocks.size((num_lines >> log2_lines_per_superblock) + 1);
+
+		num_ones = 0;
+		for (uint64_t b = 0; b < num_lines; b++) {
+			if ((b & ((1ULL << log2_lines_per_superblock) - 1)) == 0) superblocks[b >> log2_lines_per_superblock] = num_ones;
+			uint64_t *const line = lines + b * 8;
+			uint64_t ones_in_line = 0, header = 0;
+			for (int j = 0; j < 7; j++) {
+				if (j % 2 == 0 && j != 0) header |= ones_in_line << 9 * (j / 2 - 1);
+				const uint64_t w = b * 7 + j;
+				if (w < num_words) line[j + 1] = w == num_words - 1 && num_bits % 64 != 0 ? bits[w] & ((1ULL << num_bits % 64) - 1) : bits[w];
+				ones_in_line += nu(line[j + 1]);
+			}
+			line[0] = (num_ones - superblocks[b >> log2_lines_per_superblock]) << 27 | header;
+			num_ones += ones_in_line;
+		}
+
+		assert(num_ones <= num_bits);
+
+		const uint64_t num_samples = (num_ones >> log2_ones_per_sample) + 1;
+		samples.size(num_samples + 1);
+		uint64_t s = 0;
+		for (uint64_t b = 0; b < num_lines; b++)
+			while (s < num_samples && (s << log2_ones_per_sample) < (b + 1 == num_lines ? num_ones : count(b + 1))) samples[s++] = b;
+		// Samples past the last one (if any) and the sentinel point to the last line
+		while (s <= num_samples) samples[s++] = num_lines - 1;
+	}
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit InterleavedRankSel(util::Mapping &mapping) { load(mapping); }
+
+	uint64_t rank(const size_t k) {
+		const uint64_t line = k / bits_per_line;
+		const int word = k % bits_per_line / 64;
+		const uint64_t *const l = lines + line * 8;
+		const uint64_t header = l[0];
+		// l[word] (the header, if word is zero) precedes the word containing k, and it is counted only if word is odd
+		return superblocks[line >> log2_lines_per_superblock] + (header >> 27) + ((header << 9) >> 9 * (word / 2) & 0x1FF) + nu(l[word] & -uint64_t(word & 1)) +
+			   nu(l[word + 1] & ((1ULL << k % 64) - 1));
+	}
+
+	size_t select(const uint64_t rank) {
+		assert(rank < num_ones);
+		const uint64_t sample = rank >> log2_ones_per_sample;
+		uint64_t line = samples[sample], right = samples[sample + 1];
+
+		if (right - line > max_linear_span) {
+			// Invariant: count(line) <= rank < count(right + 1)
+			while (line < right) {
+				const uint64_t mid = (line + right + 1) / 2;
+				if (count(mid) <= rank)
+					line = mid;
+				else
+					right = mid - 1;
+			}
+		} else
+			while (line < right && count(line + 1) <= rank) line++;
+
+		const uint64_t *const l = lines + line * 8;
+		const uint64_t header = l[0];
+		uint64_t rank_in_line = rank - count(line);
+		const int pair = (rank_in_line >= (header & 0x1FF)) + (rank_in_line >= (header >> 9 & 0x1FF)) + (rank_in_line >= (header >> 18 & 0x1FF));
+		rank_in_line -= (header << 9) >> 9 * pair & 0x1FF;
+		int word = pair * 2;
+		const uint64_t bit_count = nu(l[word + 1]);
+		if (rank_in_line >= bit_count) {
+			rank_in_line -= bit_count;
+			word++;
+		}
+
+		assert(word < 7);
+		return line * bits_per_line + word * 64 + select64(l[word + 1], rank_in_line);
+	}
+
+	/** Returns the number of ones in the bit vector. */
+	size_t numOnes() const { return num_ones; }
+
+	size_t size() const { return num_bits; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const {
+		return storage.bitCount() - sizeof(storage) * 8 + superblocks.bitCount() - sizeof(superblocks) * 8 + samples.bitCount() - sizeof(samples) * 8 + sizeof(*this) * 8;
+	}
+};
+
+} // namespace sux::bits
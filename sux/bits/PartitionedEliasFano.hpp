@@ -0,0 +1,380 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "EliasFano.hpp"
+#include "Rank.hpp"
+#include "Select.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace sux::bits {
+
+using namespace std;
+using namespace sux;
+
+/** A partitioned Elias-Fano representation of the positions of the ones in a bit vector.
+ *
+ * The positions are split into chunks, and each chunk is stored, relatively to the position
+ * following the last element of the previous chunk, in the cheapest of three ways: no data
+ * at all, if the chunk is a run of ones; a bitmap, if the chunk is dense; and an
+ * Elias-Fano representation otherwise. The partition is chosen at construction time
+ * by dynamic programming so to minimize the overall space, with chunk boundaries at multiples of 64 elements
+ * and chunks of at most 1024 elements. On clustered sequences this
+ * representation is significantly smaller than EliasFano, and dense chunks are faster to scan.
+ *
+ * The last element of each chunk and the rank of its first element are stored
+ * in two top-level instances of EliasFano.
+ *
+ * Instances of this class can be built using a bit vector or an explicit list of
+ * positions for the ones in a vector. In every case, the bit vector or the list
+ * are not necessary after construction.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class PartitionedEliasFano : public Rank, public Select {
+  private:
+	static constexpr int log2_unit = 6;
+	static constexpr uint64_t unit = 1 << log2_unit;
+	static constexpr uint64_t max_units_per_chunk = 16;
+	// An estimate of the space in bits used by a chunk in the top-level structures.
+	static constexpr uint64_t chunk_overhead = 96;
+
+	enum : uint64_t { ALL_ONES = 0, BITMAP = 1, ELIAS_FANO = 2 };
+
+	// The last element of each chunk, and the rank of the first element of each chunk.
+	EliasFano<AT> endpoints, ranks;
+	// For each chunk, the offset in words of its data, the number of words of lower bits and the number of
+	// lower bits (if the chunk is stored using Elias-Fano) and the chunk type.
+	util::Vector<uint64_t, AT> chunks;
+	util::Vector<uint64_t, AT> data;
+	uint64_t num_bits, num_ones, num_chunks;
+
+	__inline static int ef_l(const uint64_t u, const uint64_t m) { return u / m == 0 ? 0 : lambda(u / m); }
+
+	// Returns the type of the cheapest representation of m elements out of u, and stores its size in words in words.
+	static uint64_t chunk_type(const uint64_t u, const uint64_t m, uint64_t &words) {
+		if (u == m) {
+			words = 0;
+			return ALL_ONES;
+		}
+		const int l = ef_l(u, m);
+		const uint64_t ef_words = (m * l + 63) / 64 + (m + (u >> l) + 63) / 64;
+		const uint64_t bitmap_words = (u + 63) / 64;
+		words = min(ef_words, bitmap_words);
+		return bitmap_words <= ef_words ? BITMAP : ELIAS_FANO;
+	}
+
+	__inline static uint64_t read_lower(const uint64_t *const lower_bits, const uint64_t i, const int l) {
+		const uint64_t lower_pos = i * l;
+		const uint64_t *const lower = lower_bits + lower_pos / 64;
+		return (lower[0] >> lower_pos % 64 | lower[1] << 1 << (63 - lower_pos % 64)) & ((UINT64_C(1) << l) - 1);
+	}
+
+	// The data describing a chunk.
+	struct Chunk {
+		uint64_t type, base, start;
+		int l;
+		const uint64_t *data;
+		const uint64_t *upper;
+	};
+
+	Chunk chunk(const uint64_t c) {
+		Chunk ch;
+		const uint64_t info = chunks[c];
+		ch.type = info & 3;
+		ch.l = info >> 2 & 0x3F;
+		ch.data = &data + (info >> 18);
+		ch.upper = ch.data + (info >> 8 & 0x3FF);
+		ch.base = c == 0 ? 0 : endpoints.select(c - 1) + 1;
+		ch.start = ranks.select(c);
+		return ch;
+	}
+
+	// Decodes the m elements of a chunk.
+	static void decode(const Chunk &ch, const uint64_t m, uint64_t *const out) {
+		if (ch.type == ALL_ONES) {
+			for (uint64_t i = 0; i < m; i++) out[i] = ch.base + i;
+		} else if (ch.type == BITMAP) {
+			for (uint64_t i = 0, word = 0; i < m; word++)
+				for (uint64_t window = ch.data[word]; window != 0; window &= window - 1) out[i++] = ch.base + word * 64 + rho(window);
+		} else {
+			for (uint64_t i = 0, word = 0; i < m; word++)
+				for (uint64_t window = ch.upper[word]; window != 0; window &= window - 1, i++) out[i] = ch.base + ((word * 64 + rho(window) - i) << ch.l | read_lower(ch.data, i, ch.l));
+		}
+	}
+
+	void build(const std::vector<uint64_t> &ones) {
+		num_ones = ones.size();
+		const uint64_t num_units = (num_ones + unit - 1) / unit;
+
+		// best[k] is the minimum cost of the first k units; from[k] the starting unit of the last chunk
+		std::vector<uint64_t> best(num_units + 1, UINT64_MAX), from(num_units + 1);
+		best[0] = 0;
+		for (uint64_t k = 1; k <= num_units; k++) {
+			const uint64_t end = min(k * unit, num_ones);
+			for (uint64_t j = k > max_units_per_chunk ? k - max_units_per_chunk : 0; j < k; j++) {
+				const uint64_t start = j * unit;
+				const uint64_t base = start == 0 ? 0 : ones[start - 1] + 1;
+				uint64_t words;
+				chunk_type(ones[end - 1] - base + 1, end - start, words);
+				const uint64_t cost = best[j] + words * 64 + chunk_overhead;
+				if (cost < best[k]) {
+					best[k] = cost;
+					from[k] = j;
+				}
+			}
+		}
+
+		std::vector<uint64_t> bounds;
+		for (uint64_t k = num_units; k != 0; k = from[k]) bounds.push_back(k);
+		num_chunks = bounds.size();
+
+		std::vector<uint64_t> last(num_chunks), first_rank(num_chunks);
+		chunks.size(num_chunks);
+		uint64_t total_words = 0;
+		for (uint64_t c = 0; c < num_chunks; c++) {
+			const uint64_t start = c == 0 ? 0 : bounds[num_chunks - c] * unit;
+			const uint64_t end = min(bounds[num_chunks - 1 - c] * unit, num_ones);
+			const uint64_t base = start == 0 ? 0 : ones[start - 1] + 1;
+			const uint64_t u = ones[end - 1] - base + 1, m = end - start;
+			last[c] = ones[end - 1];
+			first_rank[c] = start;
+
+			uint64_t words;
+			const uint64_t type = chunk_type(u, m, words);
+			const int l = type == ELIAS_FANO ? ef_l(u, m) : 0;
+			chunks[c] = total_words << 18 | ((m * l + 63) / 64) << 8 | uint64_t(l) << 2 | type;
+			total_words += words;
+		}
+
+		// A padding word makes branchless reads of the lower bits possible
+		data.size(total_words + 1);
+
+		for (uint64_t c = 0; c < num_chunks; c++) {
+			const uint64_t start = first_rank[c];
+			const uint64_t end = c == num_chunks - 1 ? num_ones : first_rank[c + 1];
+			const uint64_t base = start == 0 ? 0 : ones[start - 1] + 1;
+			const uint64_t m = end - start;
+			const uint64_t type = chunks[c] & 3;
+			const int l = chunks[c] >> 2 & 0x3F;
+
+			uint64_t *const p = &data + (chunks[c] >> 18);
+			if (type == BITMAP) {
+				for (uint64_t i = start; i < end; i++) p[(ones[i] - base) / 64] |= UINT64_C(1) << (ones[i] - base) % 64;
+			} else if (type == ELIAS_FANO) {
+				uint64_t *const upper = p + (m * l + 63) / 64;
+				for (uint64_t i = 0; i < m; i++) {
+					const uint64_t v = ones[start + i] - base;
+					const uint64_t lower_pos = i * l;
+					if (l != 0) {
+						p[lower_pos / 64] |= (v & ((UINT64_C(1) << l) - 1)) << lower_pos % 64;
+						if (lower_pos % 64 + l > 64) p[lower_pos / 64 + 1] |= (v & ((UINT64_C(1) << l) - 1)) >> (64 - lower_pos % 64);
+					}
+					const uint64_t upper_pos = (v >> l) + i;
+					upper[upper_pos / 64] |= UINT64_C(1) << upper_pos % 64;
+				}
+			}
+		}
+
+		endpoints = EliasFano<AT>(last, num_bits);
+		ranks = EliasFano<AT>(first_rank, num_ones);
+	}
+
+  public:
+	PartitionedEliasFano() {}
+
+	/** Creates a new instance using a given bit vector.
+	 *
+	 * Note that the bit vector is read only at construction time.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	PartitionedEliasFano(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits) {
+		std::vector<uint64_t> ones;
+		for (uint64_t i = 0; i < (num_bits + 63) / 64; i++)
+			for (uint64_t window = bits[i]; window != 0; window = window & (window - 1)) {
+				const uint64_t pos = i * 64 + rho(window);
+				if (pos < num_bits) ones.push_back(pos);
+			}
+		build(ones);
+	}
+
+	/** Creates a new instance using an
+	 *  explicit list of positions for the ones in a bit vector.
+	 *
+	 *  Note that the list is read only at construction time.
+	 *
+	 * @param ones a strictly increasing list of positions of the ones in a bit vector.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	PartitionedEliasFano(const std::vector<uint64_t> &ones, const uint64_t num_bits) : num_bits(num_bits) { build(ones); }
+
+	uint64_t rank(const size_t pos) {
+		if (num_ones == 0) return 0;
+		const uint64_t c = endpoints.rank(pos);
+		if (c == num_chunks) return num_ones;
+
+		const Chunk ch = chunk(c);
+		if (pos <= ch.base) return ch.start;
+		const uint64_t x = pos - ch.base;
+
+		switch (ch.type) {
+		case ALL_ONES:
+			return ch.start + x;
+		case BITMAP: {
+			uint64_t r = ch.start;
+			for (uint64_t i = 0; i < x / 64; i++) r += nu(ch.data[i]);
+			return r + (x % 64 == 0 ? 0 : nu(ch.data[x / 64] & ((UINT64_C(1) << x % 64) - 1)));
+		}
+		default: {
+			// Skip the first (x >> l) zeros of the upper bits, and then scan; the scan stops at the last element of the chunk, at the latest
+			uint64_t zeros = x >> ch.l, word = 0, window = ~ch.upper[0];
+			for (uint64_t bit_count; (bit_count = nu(window)) < zeros; zeros -= bit_count) window = ~ch.upper[++word];
+			uint64_t upper_pos = zeros == 0 ? 0 : word * 64 + select64(window, zeros - 1) + 1;
+			uint64_t i = upper_pos - (x >> ch.l);
+			for (;; i++, upper_pos++) {
+				while (!(ch.upper[upper_pos / 64] & UINT64_C(1) << upper_pos % 64)) upper_pos++;
+				if (((upper_pos - i) << ch.l | read_lower(ch.data, i, ch.l)) >= x) return ch.start + i;
+			}
+		}
+		}
+	}
+
+	size_t select(const uint64_t rank) {
+		const uint64_t c = ranks.rank(rank + 1) - 1;
+		const Chunk ch = chunk(c);
+		uint64_t j = rank - ch.start;
+
+		switch (ch.type) {
+		case ALL_ONES:
+			return ch.base + j;
+		case BITMAP: {
+			uint64_t word = 0;
+			for (uint64_t bit_count; (bit_count = nu(ch.data[word])) <= j; j -= bit_count) word++;
+			return ch.base + word * 64 + select64(ch.data[word], j);
+		}
+		default: {
+			uint64_t word = 0, r = j;
+			for (uint64_t bit_count; (bit_count = nu(ch.upper[word])) <= r; r -= bit_count) word++;
+			return ch.base + ((word * 64 + select64(ch.upper[word], r) - j) << ch.l | read_lower(ch.data, j, ch.l));
+		}
+		}
+	}
+
+	/** An iterator returning the positions of the ones in increasing order.
+	 *
+	 * Positions are decoded a chunk at a time in an internal buffer.
+	 */
+	class Iterator {
+		PartitionedEliasFano<AT> &pef;
+		std::vector<uint64_t> buffer;
+		uint64_t c, index, pos = 0, fill = 0, last;
+
+		// Decodes chunk c, and moves to the element of given index.
+		void enter(const uint64_t c, const uint64_t index) {
+			this->c = c;
+			this->index = index;
+			const Chunk ch = pef.chunk(c);
+			fill = (c == pef.num_chunks - 1 ? pef.num_ones : pef.ranks.select(c + 1)) - ch.start;
+			last = pef.endpoints.select(c);
+			decode(ch, fill, buffer.data());
+			pos = index - ch.start;
+		}
+
+	  public:
+		Iterator(PartitionedEliasFano<AT> &pef, const uint64_t from) : pef(pef), buffer(max_units_per_chunk * unit), index(min(from, pef.num_ones)) {
+			if (index < pef.num_ones) enter(pef.ranks.rank(index + 1) - 1, index);
+		}
+
+		/** Returns whether there are more positions to return. */
+		bool hasNext() const { return index < pef.num_ones; }
+
+		/** Returns the rank of the position that will be returned by next(). */
+		uint64_t nextIndex() const { return index; }
+
+		/** Returns the next position. */
+		uint64_t next() {
+			assert(hasNext());
+			if (pos == fill) enter(c + 1, index);
+			index++;
+			return buffer[pos++];
+		}
+
+		/** Skips to the first position greater than or equal to a given bound and returns it.
+		 *
+		 * If the bound is beyond the current chunk, the scan restarts from the chunk containing
+		 * the bound, which is located using the top-level structure.
+		 *
+		 * @param x a bound.
+		 * @return the first position greater than or equal to `x` following the last returned
+		 * position, or size() if no such position exists (in which case hasNext() becomes false).
+		 */
+		uint64_t nextGEQ(const uint64_t x) {
+			if (!hasNext()) return pef.num_bits;
+			if (x > last) {
+				const uint64_t d = pef.endpoints.rank(x);
+				if (d >= pef.num_chunks) {
+					index = pef.num_ones;
+					return pef.num_bits;
+				}
+				enter(d, pef.ranks.select(d));
+			}
+
+			while (hasNext()) {
+				const uint64_t v = next();
+				if (v >= x) return v;
+			}
+			return pef.num_bits;
+		}
+	};
+
+	/** Returns an iterator starting at a given rank.
+	 *
+	 * @param from the rank of the first position returned by the iterator.
+	 */
+	Iterator iterator(const uint64_t from = 0) { return Iterator(*this, from); }
+
+	/** Returns the number of chunks. */
+	uint64_t numChunks() const { return num_chunks; }
+
+	/** Returns the size in bits of the underlying bit vector. */
+	size_t size() const { return num_bits; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	uint64_t bitCount() {
+		return endpoints.bitCount() - sizeof(endpoints) * 8 + ranks.bitCount() - sizeof(ranks) * 8 + chunks.bitCount() - sizeof(chunks) * 8 + data.bitCount() - sizeof(data) * 8 +
+			   sizeof(*this) * 8;
+	}
+};
+
+} // namespace sux::bits
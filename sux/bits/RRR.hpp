@@ -0,0 +1,293 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "../util/Mapping.hpp"
+#include "../util/Vector.hpp"
+#include "Rank.hpp"
+#include "Select.hpp"
+#include <cstdint>
+
+namespace sux::bits {
+
+using namespace std;
+using namespace sux;
+
+/** Combinatorial tables for blocks of 15 bits used by RRR.
+ *
+ * A block with c ones (its _class_) is identified by its _offset_, that is, its index
+ * in colexicographical order among the blocks of class c, which is computed using the combinatorial number system.
+ */
+struct RRRTables {
+	static constexpr int block_bits = 15;
+
+	uint16_t binomial[block_bits + 1][block_bits + 1];
+	// The number of bits of the offsets of each class
+	uint8_t width[block_bits + 1];
+	// The sum of widths of the two classes packed in a byte
+	uint8_t width_pair[256];
+	// The start in decode of each class
+	uint16_t class_start[block_bits + 1];
+	// The block of given class and offset, at position class_start[class] + offset
+	uint16_t decode[1 << block_bits];
+};
+
+constexpr RRRTables make_rrr_tables() {
+	RRRTables t{};
+	constexpr int b = RRRTables::block_bits;
+	for (int n = 0; n <= b; n++) {
+		t.binomial[n][0] = 1;
+		for (int k = 1; k <= n; k++) t.binomial[n][k] = t.binomial[n - 1][k - 1] + (k < n ? t.binomial[n - 1][k] : 0);
+	}
+	for (int c = 0, start = 0; c <= b; c++) {
+		while ((1 << t.width[c]) < t.binomial[b][c]) t.width[c]++;
+		t.class_start[c] = start;
+		start += t.binomial[b][c];
+	}
+	for (int p = 0; p < 256; p++) t.width_pair[p] = t.width[p & 0xF] + t.width[p >> 4];
+	for (int x = 0; x < 1 << b; x++) {
+		int c = 0, offset = 0;
+		for (int p = 0; p < b; p++)
+			if (x >> p & 1) offset += t.binomial[p][++c];
+		t.decode[t.class_start[c] + offset] = x;
+	}
+	return t;
+}
+
+inline constexpr RRRTables rrr_tables = make_rrr_tables();
+
+/** A compressed bit vector supporting ranking and selection, based on the class/offset representation of Raman, Raman and Rao.
+ *
+ * The bit vector is divided in blocks of 15 bits. Each block is represented by its _class_ (i.e., its number
+ * of ones), stored in four bits, and by its _offset_, that is, its index among the blocks of the same class,
+ * stored in as many bits as necessary for the class (from zero for all-zeros or all-ones blocks to 13).
+ * Offsets are decoded using a precomputed table of 32768 entries.
+ *
+ * Every 32 blocks (480 bits), a superblock stores the number of ones before it and the position of
+ * the offset of its first block. Ranking scans the classes of the superblock up to the
+ * desired block, and decodes the latter. Selection uses a sample of the superblock containing
+ * every 512th one to restrict a binary search over the superblocks, and then scans classes.
+ *
+ * The space used is about 0.53 bits per bit for classes and superblocks, plus the space for offsets,
+ * which is close to the empirical entropy of the bit vector, and smaller when ones and zeros are clustered.
+ * The bit vector is not necessary after construction.
+ *
+ * Instances can be serialized with the `<<` and `>>` operators, and a read-only
+ * view of a serialized instance can be created without copying from a util::Mapping.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class RRR : public Rank, public Select {
+  private:
+	static constexpr int block_bits = RRRTables::block_bits;
+	static constexpr int log2_blocks_per_superblock = 5;
+	static constexpr uint64_t blocks_per_superblock = 1 << log2_blocks_per_superblock;
+	static constexpr int log2_ones_per_select_sample = 9;
+
+	uint64_t num_bits, num_ones;
+	// Classes, packed in nibbles
+	util::Vector<uint64_t, AT> classes;
+	util::Vector<uint64_t, AT> offsets;
+	// For each superblock (plus a sentinel), the number of ones before it and the position of its first offset
+	util::Vector<uint64_t, AT> superblocks;
+	// The superblock containing each one of index multiple of 2^log2_ones_per_select_sample, plus a sentinel
+	util::Vector<uint64_t, AT> select_samples;
+
+	__inline static uint64_t get_bits(const uint64_t *const bits, const uint64_t start, const int width) {
+		const uint64_t *const w = bits + start / 64;
+		const int shift = start % 64;
+		return (w[0] >> shift | (shift + width > 64 ? w[1] << (64 - shift) : 0)) & ((UINT64_C(1) << width) - 1);
+	}
+
+	__inline int get_class(const uint64_t block) const { return classes[block / 16] >> block % 16 * 4 & 0xF; }
+
+	__inline uint64_t decode(const int c, const uint64_t offset_pos) const { return rrr_tables.decode[rrr_tables.class_start[c] + get_bits(&offsets, offset_pos, rrr_tables.width[c])]; }
+
+	void save(std::ostream &os) const {
+		util::save(os, num_bits);
+		util::save(os, num_ones);
+		util::save(os, classes);
+		util::save(os, offsets);
+		util::save(os, superblocks);
+		util::save(os, select_samples);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, num_bits);
+		util::load(src, num_ones);
+		util::load(src, classes);
+		util::load(src, offsets);
+		util::load(src, superblocks);
+		util::load(src, select_samples);
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const RRR<AT> &rrr) {
+		rrr.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, RRR<AT> &rrr) {
+		rrr.load(is);
+		return is;
+	}
+
+  public:
+	RRR() {}
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit RRR(util::Mapping &mapping) { load(mapping); }
+
+	/** Creates a new instance using a given bit vector.
+	 *
+	 * Note that the bit vector is read only at construction time.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	RRR(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits), num_ones(0) {
+		const uint64_t num_blocks = (num_bits + block_bits - 1) / block_bits;
+		const uint64_t num_superblocks = (num_blocks + blocks_per_superblock - 1) / blocks_per_superblock;
+		// Superblocks fill exactly two words of classes
+		classes.size(2 * num_superblocks + 1);
+		superblocks.size(2 * num_superblocks + 2);
+
+		// First pass: classes, superblocks and the number of bits of offsets
+		uint64_t offset_bits = 0;
+		for (uint64_t block = 0; block < num_blocks; block++) {
+			if (block % blocks_per_superblock == 0) {
+				superblocks[2 * (block / blocks_per_superblock)] = num_ones;
+				superblocks[2 * (block / blocks_per_superblock) + 1] = offset_bits;
+			}
+			const uint64_t start = block * block_bits;
+			const int c = nu(get_bits(bits, start, min(uint64_t(block_bits), num_bits - start)));
+			classes[block / 16] |= uint64_t(c) << block % 16 * 4;
+			num_ones += c;
+			offset_bits += rrr_tables.width[c];
+		}
+		superblocks[2 * num_superblocks] = num_ones;
+		superblocks[2 * num_superblocks + 1] = offset_bits;
+
+		// Second pass: offsets (with a free word for reading) and select samples
+		offsets.size((offset_bits + 63) / 64 + 1);
+		select_samples.size((num_ones >> log2_ones_per_select_sample) + 2);
+		const uint64_t sample_mask = (UINT64_C(1) << log2_ones_per_select_sample) - 1;
+		uint64_t offset_pos = 0, ones = 0;
+		for (uint64_t block = 0; block < num_blocks; block++) {
+			const uint64_t start = block * block_bits;
+			const uint64_t x = get_bits(bits, start, min(uint64_t(block_bits), num_bits - start));
+			int c = 0;
+			uint64_t offset = 0;
+			for (uint64_t w = x; w != 0; w &= w - 1) offset += rrr_tables.binomial[rho(w)][++c];
+			if (offset != 0) {
+				offsets[offset_pos / 64] |= offset << offset_pos % 64;
+				if (offset_pos % 64 + rrr_tables.width[c] > 64) offsets[offset_pos / 64 + 1] |= offset >> (64 - offset_pos % 64);
+			}
+			offset_pos += rrr_tables.width[c];
+
+			if (((ones + sample_mask) & ~sample_mask) < ones + c) select_samples[(ones + sample_mask) >> log2_ones_per_select_sample] = block / blocks_per_superblock;
+			ones += c;
+		}
+		for (uint64_t i = (num_ones + sample_mask) >> log2_ones_per_select_sample; i < select_samples.size(); i++) select_samples[i] = num_superblocks == 0 ? 0 : num_superblocks - 1;
+	}
+
+	uint64_t rank(const size_t pos) {
+		const uint64_t block = pos / block_bits;
+		const uint64_t superblock = block / blocks_per_superblock;
+		uint64_t rank = superblocks[2 * superblock], offset_pos = superblocks[2 * superblock + 1];
+
+		// Each byte contains the classes of two blocks
+		const uint8_t *const pairs = (const uint8_t *)&classes + superblock * (blocks_per_superblock / 2);
+		const int k = block % blocks_per_superblock;
+		for (int i = 0; i < k / 2; i++) {
+			rank += (pairs[i] & 0xF) + (pairs[i] >> 4);
+			offset_pos += rrr_tables.width_pair[pairs[i]];
+		}
+		if (k % 2) {
+			const int c = pairs[k / 2] & 0xF;
+			rank += c;
+			offset_pos += rrr_tables.width[c];
+		}
+
+		const int shift = pos % block_bits;
+		if (shift == 0) return rank;
+		return rank + nu(decode(get_class(block), offset_pos) & ((UINT64_C(1) << shift) - 1));
+	}
+
+	size_t select(const uint64_t rank) {
+		assert(rank < num_ones);
+		// The last superblock whose first one has index at most rank
+		const uint64_t sample = rank >> log2_ones_per_select_sample;
+		uint64_t lo = select_samples[sample], hi = select_samples[sample + 1] + 1;
+		while (hi - lo > 1) {
+			const uint64_t mid = (lo + hi) / 2;
+			if (superblocks[2 * mid] <= rank)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		uint64_t residual = rank - superblocks[2 * lo], offset_pos = superblocks[2 * lo + 1];
+		const uint8_t *const pairs = (const uint8_t *)&classes + lo * (blocks_per_superblock / 2);
+		int i = 0;
+		for (;; i++) {
+			const uint64_t c = (pairs[i] & 0xF) + (pairs[i] >> 4);
+			if (residual < c) break;
+			residual -= c;
+			offset_pos += rrr_tables.width_pair[pairs[i]];
+		}
+
+		uint64_t block = lo * blocks_per_superblock + 2 * i;
+		int c = pairs[i] & 0xF;
+		if (residual >= uint64_t(c)) {
+			residual -= c;
+			offset_pos += rrr_tables.width[c];
+			block++;
+			c = pairs[i] >> 4;
+		}
+		return block * block_bits + select64(decode(c, offset_pos), residual);
+	}
+
+	/** Returns the number of ones. */
+	uint64_t numOnes() const { return num_ones; }
+
+	size_t size() const { return num_bits; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const {
+		return classes.bitCount() - sizeof(classes) * 8 + offsets.bitCount() - sizeof(offsets) * 8 + superblocks.bitCount() - sizeof(superblocks) * 8 + select_samples.bitCount() -
+			   sizeof(select_samples) * 8 + sizeof(*this) * 8;
+	}
+};
+
+} // namespace sux::bits
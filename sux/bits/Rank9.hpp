@@ -29,10 +29,14 @@
 #pragma once
 
 #include "../support/common.hpp"
+#include "../support/parallel.hpp"
+#include "../util/Mapping.hpp"
 #include "../util/Vector.hpp"
 #include "Rank.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 namespace sux::bits {
 
@@ -44,22 +48,66 @@ using namespace sux;
  * The constructors of this class only store a reference
  * to a provided bit vector. Should the content of the
  * bit vector change, the results will be unpredictable.
+ * Alternatively, a bit vector can be moved into an instance
+ * as a util::Vector, so that it uses the same type of
+ * memory allocation of the structure.
  *
  * **Warning**: if you plan an calling rank(size_t) with
  * argument size(), you must have at least one additional
  * free bit at the end of the provided bit vector.
  *
+ * Instances can be serialized with the `<<` and `>>` operators, and
+ * the serialized form includes the bit vector: deserialized instances
+ * own a copy of it. A read-only view of a serialized instance can be
+ * created without copying from a util::Mapping.
+ *
  * @tparam AT a type of memory allocation out of sux::util::AllocType.
  */
 
 template <util::AllocType AT = util::AllocType::MALLOC> class Rank9 : public Rank {
   protected:
-	const size_t num_bits;
+	size_t num_bits;
 	size_t num_ones;
 	const uint64_t *bits;
 	util::Vector<uint64_t, AT> counts;
+	// The bit vector of owning or deserialized instances
+	util::Vector<uint64_t, AT> owned_bits;
+
+	// Takes ownership of the bit vector referenced by bits, adding a free word if necessary
+	void own(util::Vector<uint64_t, AT> &&bits) {
+		owned_bits = std::move(bits);
+		if (owned_bits.size() <= num_bits / 64) owned_bits.size(num_bits / 64 + 1);
+		this->bits = &owned_bits;
+	}
+
+	void save(std::ostream &os) const {
+		util::save(os, num_bits);
+		util::save(os, num_ones);
+		util::save_bits(os, bits, num_bits);
+		util::save(os, counts);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, num_bits);
+		util::load(src, num_ones);
+		util::load(src, owned_bits);
+		util::load(src, counts);
+		bits = &owned_bits;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const Rank9<AT> &rank9) {
+		rank9.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, Rank9<AT> &rank9) {
+		rank9.load(is);
+		return is;
+	}
 
   public:
+	Rank9() {}
+
 	/** Creates a new instance using a given bit vector.
 	 *
 	 *  Note that this constructor only stores a reference
@@ -72,36 +120,88 @@ template <util::AllocType AT = util::AllocType::MALLOC> class Rank9 : public Ran
 	 *
 	 * @param bits a bit vector of 64-bit words.
 	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread fills the counts of a slice of the blocks.
 	 */
 
-	Rank9(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits), bits(bits) {
+	Rank9(const uint64_t *const bits, const uint64_t num_bits, const int threads = 1) : num_bits(num_bits), bits(bits) {
 		const uint64_t num_words = (num_bits + 63) / 64;
-		const uint64_t num_counts = ((num_bits + 64 * 8 - 1) / (64 * 8)) * 2;
+		const uint64_t num_blocks = (num_bits + 64 * 8 - 1) / (64 * 8);
+		const uint64_t num_counts = num_blocks * 2;
 
 		// Init rank structure
 		counts.size(num_counts + 2);
 
-		num_ones = 0;
-		uint64_t pos = 0;
-		for (uint64_t i = 0; i < num_words; i += 8, pos += 2) {
-			counts[pos] = num_ones;
-			num_ones += __builtin_popcountll(bits[i]);
-			for (int j = 1; j < 8; j++) {
-				counts[pos + 1] |= (num_ones - counts[pos]) << 9 * (j - 1);
-				if (i + j < num_words) num_ones += __builtin_popcountll(bits[i + j]);
+		// First pass: the number of ones in each slice of blocks
+		std::vector<uint64_t> slice_ones(threads + 1);
+		parallel_slices(num_blocks, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			uint64_t c = 0;
+			for (uint64_t i = from * 8; i < std::min(to * 8, num_words); i++) c += nu(bits[i]);
+			slice_ones[t + 1] = c;
+		});
+		for (int t = 0; t < threads; t++) slice_ones[t + 1] += slice_ones[t];
+
+		// Second pass: each slice fills its counts starting from its number of preceding ones
+		parallel_slices(num_blocks, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			uint64_t ones = slice_ones[t];
+			for (uint64_t i = from * 8, pos = from * 2; i < to * 8; i += 8, pos += 2) {
+				counts[pos] = ones;
+				ones += nu(bits[i]);
+				for (int j = 1; j < 8; j++) {
+					counts[pos + 1] |= (ones - counts[pos]) << 9 * (j - 1);
+					if (i + j < num_words) ones += nu(bits[i + j]);
+				}
 			}
-		}
+		});
 
+		num_ones = slice_ones[threads];
 		counts[num_counts] = num_ones;
 
 		assert(num_ones <= num_bits);
 	}
 
+	/** Creates a new instance owning a given bit vector.
+	 *
+	 * The bit vector is moved into the new instance, and it is extended if necessary
+	 * so that rank(size_t) can be called with argument size().
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread fills the counts of a slice of the blocks.
+	 */
+	Rank9(util::Vector<uint64_t, AT> &&bits, const uint64_t num_bits, const int threads = 1) : Rank9(&bits, num_bits, threads) { own(std::move(bits)); }
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit Rank9(util::Mapping &mapping) { load(mapping); }
+
 	uint64_t rank(const size_t k) {
 		const uint64_t word = k / 64;
 		const uint64_t block = word / 4 & ~1;
 		const int offset = word % 8 - 1;
-		return counts[block] + (counts[block + 1] >> (offset + (offset >> (sizeof offset * 8 - 4) & 0x8)) * 9 & 0x1FF) + __builtin_popcountll(bits[word] & ((1ULL << k % 64) - 1));
+		return counts[block] + (counts[block + 1] >> (offset + (offset >> (sizeof offset * 8 - 4) & 0x8)) * 9 & 0x1FF) + nu(bits[word] & ((1ULL << k % 64) - 1));
+	}
+
+	/** Computes the ranks of a batch of positions.
+	 *
+	 * Positions are processed in windows of ::BATCH_WINDOW queries: the counts and the
+	 * words needed by all queries in a window are prefetched before answering them, so
+	 * that the cache misses of independent queries overlap.
+	 *
+	 * @param pos an array of `n` positions, each from 0 to size() (included).
+	 * @param out an array of `n` elements that will contain the ranks of the positions in `pos`.
+	 * @param n the number of positions.
+	 */
+	void rank(const uint64_t *const pos, uint64_t *const out, const size_t n) {
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t e = std::min(n, b + BATCH_WINDOW);
+			for (size_t i = b; i < e; i++) {
+				__builtin_prefetch(&counts + (pos[i] / 64 / 4 & ~1));
+				__builtin_prefetch(bits + pos[i] / 64);
+			}
+			for (size_t i = b; i < e; i++) out[i] = rank(pos[i]);
+		}
 	}
 
 	/** Returns an estimate of the size in bits of this structure. */
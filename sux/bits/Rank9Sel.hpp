@@ -29,6 +29,7 @@
 #pragma once
 
 #include "../support/common.hpp"
+#include "../support/parallel.hpp"
 #include "Rank9.hpp"
 #include "Select.hpp"
 #include <cstdint>
@@ -42,10 +43,14 @@ namespace sux::bits {
  * The constructors of this class only store a reference
  * to a provided bit vector. Should the content of the
  * bit vector change, the results will be unpredictable.
+ * Alternatively, a bit vector can be moved into an instance
+ * as a util::Vector, as in Rank9.
  *
  * **Warning**: if you plan an calling rank(size_t) with
  * argument size(), you must have at least one additional
  * free bit at the end of the provided bit vector.
+ *
+ * Serialization and views work as in Rank9.
  */
 template <util::AllocType AT = util::AllocType::MALLOC> class Rank9Sel : public Rank9<AT>, public Select {
   private:
@@ -56,7 +61,33 @@ template <util::AllocType AT = util::AllocType::MALLOC> class Rank9Sel : public
 	util::Vector<uint64_t, AT> inventory, subinventory;
 	uint64_t inventory_size;
 
+	void save(std::ostream &os) const {
+		Rank9<AT>::save(os);
+		util::save(os, inventory_size);
+		util::save(os, inventory);
+		util::save(os, subinventory);
+	}
+
+	template <typename S> void load(S &src) {
+		Rank9<AT>::load(src);
+		util::load(src, inventory_size);
+		util::load(src, inventory);
+		util::load(src, subinventory);
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const Rank9Sel<AT> &rank9sel) {
+		rank9sel.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, Rank9Sel<AT> &rank9sel) {
+		rank9sel.load(is);
+		return is;
+	}
+
   public:
+	Rank9Sel() {}
+
 	/** Creates a new instance using a given bit vector.
 	 *
 	 * Note that this constructor only stores a reference
@@ -69,9 +100,10 @@ template <util::AllocType AT = util::AllocType::MALLOC> class Rank9Sel : public
 	 *
 	 * @param bits a bit vector of 64-bit words.
 	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
 	 */
 
-	Rank9Sel(const uint64_t *const bits, const uint64_t num_bits) : Rank9<AT>(bits, num_bits) {
+	Rank9Sel(const uint64_t *const bits, const uint64_t num_bits, const int threads = 1) : Rank9<AT>(bits, num_bits, threads) {
 		const uint64_t num_words = (num_bits + 63) / 64;
 		inventory_size = (this->num_ones + ones_per_inventory - 1) / ones_per_inventory;
 
@@ -83,116 +115,127 @@ template <util::AllocType AT = util::AllocType::MALLOC> class Rank9Sel : public
 		inventory.size(inventory_size + 1);
 		subinventory.size((num_words + 3) / 4);
 
-		uint64_t d = 0;
-		for (uint64_t i = 0; i < num_words; i++)
-			for (int j = 0; j < 64; j++)
-				if (bits[i] & 1ULL << j) {
-					if ((d & inventory_mask) == 0) {
-						inventory[d >> log2_ones_per_inventory] = i * 64 + j;
-						assert(this->counts[(i / 8) * 2] <= d);
-						assert(this->counts[(i / 8) * 2 + 2] > d);
-					}
+		// Like Rank9, we use all bits of the last word
+		const std::vector<uint64_t> slice_rank = slice_ranks(bits, num_words * 64, threads);
+		assert(this->num_ones == slice_rank[threads]);
 
-					d++;
-				}
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones(bits, num_words * 64, from, to, slice_rank[t], mround(slice_rank[t], ones_per_inventory), [&](const uint64_t d, const uint64_t pos) {
+				inventory[d >> log2_ones_per_inventory] = pos;
+				assert(this->counts[(pos / 64 / 8) * 2] <= d);
+				assert(this->counts[(pos / 64 / 8) * 2 + 2] > d);
+				return d + ones_per_inventory;
+			});
+		});
 
-		assert(this->num_ones == d);
 		inventory[inventory_size] = ((num_words + 3) & ~3ULL) * 64;
 
 #ifdef DEBUG
 		printf("Inventory size: %" PRId64 "\n", inventory_size);
-		printf("Inventory entries filled: %" PRId64 "\n", d / ones_per_inventory + 1);
 		// printf("First inventories: %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 "\n", inventory[0],
 		// inventory[1], inventory[2],
 		//       inventory[3]);
 #endif
 
-		d = 0;
-		int state;
-		uint64_t *s, first_bit, index, span, block_span, block_left, counts_at_start;
-
-		for (uint64_t i = 0; i < num_words; i++)
-			for (int j = 0; j < 64; j++)
-				if (bits[i] & 1ULL << j) {
-					if ((d & inventory_mask) == 0) {
-						first_bit = i * 64 + j;
-						index = d >> log2_ones_per_inventory;
-						assert(inventory[index] == first_bit);
-						s = &subinventory[(inventory[index] / 64) / 4];
-						span = (inventory[index + 1] / 64) / 4 - (inventory[index] / 64) / 4;
-						state = -1;
-						counts_at_start = this->counts[((inventory[index] / 64) / 8) * 2];
-						block_span = (inventory[index + 1] / 64) / 8 - (inventory[index] / 64) / 8;
-						block_left = (inventory[index] / 64) / 8;
-
-						if (span >= 512)
-							state = 0;
-						else if (span >= 256)
-							state = 1;
-						else if (span >= 128)
-							state = 2;
-						else if (span >= 16) {
-							assert(((block_span + 8) & -8LL) + 8 <= span * 4);
-
-							uint64_t k;
-							for (k = 0; k < block_span; k++) {
-								assert(((uint16_t *)s)[k + 8] == 0);
-								((uint16_t *)s)[k + 8] = this->counts[(block_left + k + 1) * 2] - counts_at_start;
-							}
-
-							for (; k < ((block_span + 8) & -8LL); k++) {
-								assert(((uint16_t *)s)[k + 8] == 0);
-								((uint16_t *)s)[k + 8] = 0xFFFFU;
-							}
-
-							assert(block_span / 8 <= 8);
-
-							for (k = 0; k < block_span / 8; k++) {
-								assert(((uint16_t *)s)[k] == 0);
-								((uint16_t *)s)[k] = this->counts[(block_left + (k + 1) * 8) * 2] - counts_at_start;
-							}
-
-							for (; k < 8; k++) {
-								assert(((uint16_t *)s)[k] == 0);
-								((uint16_t *)s)[k] = 0xFFFFU;
-							}
-						} else if (span >= 2) {
-							assert(((block_span + 8) & -8LL) <= span * 4);
-
-							uint64_t k;
-							for (k = 0; k < block_span; k++) {
-								assert(((uint16_t *)s)[k] == 0);
-								((uint16_t *)s)[k] = this->counts[(block_left + k + 1) * 2] - counts_at_start;
-							}
-
-							for (; k < ((block_span + 8) & -8LL); k++) {
-								assert(((uint16_t *)s)[k] == 0);
-								((uint16_t *)s)[k] = 0xFFFFU;
-							}
-						}
+		// Subinventories of inventories with a small span contain counts, and are filled without looking at the bit vector
+		parallel_slices(inventory_size, threads, [&](const int, const uint64_t from, const uint64_t to) {
+			for (uint64_t index = from; index < to; index++) {
+				uint16_t *const s = (uint16_t *)&subinventory[(inventory[index] / 64) / 4];
+				const uint64_t span = (inventory[index + 1] / 64) / 4 - (inventory[index] / 64) / 4;
+				const uint64_t counts_at_start = this->counts[((inventory[index] / 64) / 8) * 2];
+				const uint64_t block_span = (inventory[index + 1] / 64) / 8 - (inventory[index] / 64) / 8;
+				const uint64_t block_left = (inventory[index] / 64) / 8;
+
+				if (span >= 128) continue;
+
+				if (span >= 16) {
+					assert(((block_span + 8) & -8LL) + 8 <= span * 4);
+
+					uint64_t k;
+					for (k = 0; k < block_span; k++) {
+						assert(s[k + 8] == 0);
+						s[k + 8] = this->counts[(block_left + k + 1) * 2] - counts_at_start;
+					}
+
+					for (; k < ((block_span + 8) & -8LL); k++) {
+						assert(s[k + 8] == 0);
+						s[k + 8] = 0xFFFFU;
+					}
+
+					assert(block_span / 8 <= 8);
+
+					for (k = 0; k < block_span / 8; k++) {
+						assert(s[k] == 0);
+						s[k] = this->counts[(block_left + (k + 1) * 8) * 2] - counts_at_start;
 					}
 
-					switch (state) {
-					case 0:
-						assert(s[d & inventory_mask] == 0);
-						s[d & inventory_mask] = i * 64 + j;
-						break;
-					case 1:
-						assert(((uint32_t *)s)[d & inventory_mask] == 0);
-						assert(i * 64 + j - first_bit < (1ULL << 32));
-						((uint32_t *)s)[d & inventory_mask] = i * 64 + j - first_bit;
-						break;
-					case 2:
-						assert(((uint16_t *)s)[d & inventory_mask] == 0);
-						assert(i * 64 + j - first_bit < (1 << 16));
-						((uint16_t *)s)[d & inventory_mask] = i * 64 + j - first_bit;
-						break;
+					for (; k < 8; k++) {
+						assert(s[k] == 0);
+						s[k] = 0xFFFFU;
 					}
+				} else if (span >= 2) {
+					assert(((block_span + 8) & -8LL) <= span * 4);
 
-					d++;
+					uint64_t k;
+					for (k = 0; k < block_span; k++) {
+						assert(s[k] == 0);
+						s[k] = this->counts[(block_left + k + 1) * 2] - counts_at_start;
+					}
+
+					for (; k < ((block_span + 8) & -8LL); k++) {
+						assert(s[k] == 0);
+						s[k] = 0xFFFFU;
+					}
 				}
+			}
+		});
+
+		// Subinventories of inventories with a large span contain the position of every one, and
+		// are filled by scanning the bit vector, skipping entirely inventories with a small span
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones(bits, num_words * 64, from, to, slice_rank[t], slice_rank[t], [&](const uint64_t d, const uint64_t pos) {
+				const uint64_t index = d >> log2_ones_per_inventory;
+				const uint64_t first_bit = inventory[index];
+				uint64_t *const s = &subinventory[(first_bit / 64) / 4];
+				const uint64_t span = (inventory[index + 1] / 64) / 4 - (first_bit / 64) / 4;
+
+				if (span < 128) return (index + 1) << log2_ones_per_inventory;
+
+				if (span >= 512) {
+					assert(s[d & inventory_mask] == 0);
+					s[d & inventory_mask] = pos;
+				} else if (span >= 256) {
+					assert(((uint32_t *)s)[d & inventory_mask] == 0);
+					assert(pos - first_bit < (1ULL << 32));
+					((uint32_t *)s)[d & inventory_mask] = pos - first_bit;
+				} else {
+					assert(((uint16_t *)s)[d & inventory_mask] == 0);
+					assert(pos - first_bit < (1 << 16));
+					((uint16_t *)s)[d & inventory_mask] = pos - first_bit;
+				}
+
+				return d + 1;
+			});
+		});
 	}
 
+	/** Creates a new instance owning a given bit vector.
+	 *
+	 * The bit vector is moved into the new instance, and it is extended if necessary
+	 * so that rank(size_t) can be called with argument size().
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
+	 */
+	Rank9Sel(util::Vector<uint64_t, AT> &&bits, const uint64_t num_bits, const int threads = 1) : Rank9Sel(&bits, num_bits, threads) { this->own(std::move(bits)); }
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit Rank9Sel(util::Mapping &mapping) { load(mapping); }
+
 	size_t select(const uint64_t rank) {
 		const uint64_t inventory_index_left = rank >> log2_ones_per_inventory;
 		assert(inventory_index_left <= inventory_size);
@@ -290,6 +333,29 @@ template <util::AllocType AT = util::AllocType::MALLOC> class Rank9Sel : public
 		return word * UINT64_C(64) + select64(this->bits[word], rank_in_word);
 	}
 
+	/** Computes the positions of the ones of a batch of ranks.
+	 *
+	 * Ranks are processed in windows of ::BATCH_WINDOW queries, in stages: first the inventory
+	 * entries of all queries in a window are prefetched, then the subinventories and counts they point to,
+	 * and finally the queries are answered, so that the cache misses of independent queries overlap.
+	 *
+	 * @param rank an array of `n` ranks.
+	 * @param out an array of `n` elements that will contain the positions of the ones of given ranks.
+	 * @param n the number of ranks.
+	 */
+	void select(const uint64_t *const rank, uint64_t *const out, const size_t n) {
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t e = std::min(n, b + BATCH_WINDOW);
+			for (size_t i = b; i < e; i++) __builtin_prefetch(&inventory + (rank[i] >> log2_ones_per_inventory));
+			for (size_t i = b; i < e; i++) {
+				const uint64_t block_left = inventory[rank[i] >> log2_ones_per_inventory] / 64;
+				__builtin_prefetch(&subinventory + block_left / 4);
+				__builtin_prefetch(&this->counts + ((block_left & ~7) / 4 & ~1));
+			}
+			for (size_t i = b; i < e; i++) out[i] = select(rank[i]);
+		}
+	}
+
 	size_t bitCount() const {
 		return this->counts.bitCount() - sizeof(this->counts) * 8 + inventory.bitCount() - sizeof(inventory) * 8 + subinventory.bitCount() - sizeof(subinventory) * 8 + sizeof(*this) * 8;
 	}
@@ -0,0 +1,212 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2020 Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "../util/Mapping.hpp"
+#include "../util/Vector.hpp"
+#include "Rank.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace sux::bits {
+
+using namespace sux;
+
+/** A class implementing a ranking structure using about 3% additional space.
+ *
+ * The bit vector is divided in superblocks of 2<sup>32</sup> bits, whose absolute counts
+ * are stored in a separate, tiny array, and in blocks of 2048 bits. For each
+ * block we store a 64-bit word containing in its lower 32 bits the number of ones before
+ * the block relative to its superblock, followed by the number of ones in the first three
+ * 512-bit subblocks of the block in three 10-bit fields. The ones in the
+ * subblock containing the argument of rank(size_t) are counted word by word,
+ * using `VPOPCNTQ` on a masked load if the host supports the AVX-512 extension `VPOPCNTDQ`.
+ *
+ * Ranking is slower than with Rank9, as it might require counting up to
+ * eight words instead of one, but the space overhead is 3.125% instead of 25%.
+ *
+ * The constructors of this class only store a reference
+ * to a provided bit vector. Should the content of the
+ * bit vector change, the results will be unpredictable.
+ * Alternatively, a bit vector can be moved into an instance
+ * as a util::Vector, as in Rank9.
+ *
+ * **Warning**: if you plan an calling rank(size_t) with
+ * argument size(), you must have at least one additional
+ * free bit at the end of the provided bit vector.
+ *
+ * Serialization and views work as in Rank9.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class RankSmall : public Rank {
+  private:
+	static constexpr int log2_bits_per_superblock = 32;
+	static constexpr int log2_bits_per_block = 11;
+
+	size_t num_bits, num_ones;
+	const uint64_t *bits;
+	util::Vector<uint64_t, AT> superblocks, counts;
+	// The bit vector of owning or deserialized instances
+	util::Vector<uint64_t, AT> owned_bits;
+
+	void save(std::ostream &os) const {
+		util::save(os, num_bits);
+		util::save(os, num_ones);
+		util::save_bits(os, bits, num_bits);
+		util::save(os, superblocks);
+		util::save(os, counts);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, num_bits);
+		util::load(src, num_ones);
+		util::load(src, owned_bits);
+		util::load(src, superblocks);
+		util::load(src, counts);
+		bits = &owned_bits;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const RankSmall<AT> &rank_small) {
+		rank_small.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, RankSmall<AT> &rank_small) {
+		rank_small.load(is);
+		return is;
+	}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+// The AVX-512 intrinsics of some versions of gcc cause spurious warnings
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	__attribute__((target("avx512f,avx512vpopcntdq"))) static uint64_t count_prefix_avx512(const uint64_t *const subblock, const int n) {
+		return _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_maskz_loadu_epi64((1U << n) - 1, subblock)));
+	}
+#endif
+
+	// Returns the number of ones in the first n words of a subblock, without reading the following ones.
+	__inline static uint64_t count_prefix(const uint64_t *const subblock, const int n) {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512F__)
+		return count_prefix_avx512(subblock, n);
+#else
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+		// Portable builds use AVX-512 if the host supports it (see sux::cpu_features)
+		if (cpu_features.avx512_vpopcntdq) return count_prefix_avx512(subblock, n);
+#endif
+		uint64_t c = 0;
+		for (int i = 0; i < n; i++) c += nu(subblock[i]);
+		return c;
+#endif
+	}
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+  public:
+	RankSmall() {}
+
+	/** Creates a new instance using a given bit vector.
+	 *
+	 *  Note that this constructor only stores a reference
+	 *  to the provided bit vector. Should the content of the
+	 *  bit vector change, the results will be unpredictable.
+	 *
+	 *  **Warning**: if you plan an calling rank(size_t) with
+	 *  argument size(), you must have at least one additional
+	 *  free bit at the end of the provided bit vector.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	RankSmall(const uint64_t *const bits, const uint64_t num_bits) : num_bits(num_bits), bits(bits) {
+		const uint64_t num_words = (num_bits + 63) / 64;
+		const uint64_t num_blocks = (num_bits >> log2_bits_per_block) + 1;
+
+		superblocks.size((num_bits >> log2_bits_per_superblock) + 1);
+		counts.size(num_blocks);
+
+		num_ones = 0;
+		for (uint64_t b = 0; b < num_blocks; b++) {
+			if ((b & ((1ULL << (log2_bits_per_superblock - log2_bits_per_block)) - 1)) == 0) superblocks[b >> (log2_bits_per_superblock - log2_bits_per_block)] = num_ones;
+			uint64_t entry = num_ones - superblocks[b >> (log2_bits_per_superblock - log2_bits_per_block)];
+			for (int s = 0; s < 4; s++) {
+				uint64_t ones_in_subblock = 0;
+				for (uint64_t w = b * 32 + s * 8; w < std::min(num_words, b * 32 + s * 8 + 8); w++) ones_in_subblock += nu(bits[w]);
+				if (s < 3) entry |= ones_in_subblock << (32 + 10 * s);
+				num_ones += ones_in_subblock;
+			}
+			counts[b] = entry;
+		}
+
+		assert(num_ones <= num_bits);
+	}
+
+	/** Creates a new instance owning a given bit vector.
+	 *
+	 * The bit vector is moved into the new instance, and it is extended if necessary
+	 * so that rank(size_t) can be called with argument size().
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 */
+	RankSmall(util::Vector<uint64_t, AT> &&bits, const uint64_t num_bits) : RankSmall(&bits, num_bits) {
+		owned_bits = std::move(bits);
+		if (owned_bits.size() <= num_bits / 64) owned_bits.size(num_bits / 64 + 1);
+		this->bits = &owned_bits;
+	}
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit RankSmall(util::Mapping &mapping) { load(mapping); }
+
+	uint64_t rank(const size_t k) {
+		const uint64_t word = k / 64;
+		const uint64_t entry = counts[k >> log2_bits_per_block];
+		// The fields of the subblocks preceding the one containing k
+		const uint64_t fields = entry >> 32 & ((1ULL << 10 * (word / 8 % 4)) - 1);
+		return superblocks[k >> log2_bits_per_superblock] + uint32_t(entry) + (fields & 0x3FF) + (fields >> 10 & 0x3FF) + (fields >> 20) + count_prefix(bits + (word & ~7), word % 8) +
+			   nu(bits[word] & ((1ULL << k % 64) - 1));
+	}
+
+	size_t size() const { return num_bits; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const { return superblocks.bitCount() - sizeof(superblocks) * 8 + counts.bitCount() - sizeof(counts) * 8 + sizeof(*this) * 8; }
+};
+
+} // namespace sux::bits
@@ -29,6 +29,8 @@
 #pragma once
 
 #include "../support/common.hpp"
+#include "../support/parallel.hpp"
+#include "../util/Mapping.hpp"
 #include "../util/Vector.hpp"
 #include "SelectZero.hpp"
 #include <cstdint>
@@ -45,6 +47,10 @@ using namespace std;
  * The constructors of this class only store a reference
  * to a provided bit vector. Should the content of the
  * bit vector change, the results will be unpredictable.
+ * Alternatively, a bit vector can be moved into an instance
+ * as a util::Vector, as in Rank9.
+ *
+ * Serialization and views work as in Rank9.
  *
  * @tparam AT a type of memory allocation out of sux::util::AllocType.
  */
@@ -60,26 +66,104 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZero {
 		longwords_per_inventory, zeros_per_inventory_mask, zeros_per_sub16_mask, zeros_per_sub64_mask;
 
 	uint64_t num_words, inventory_size, exact_spill_size, num_zeros;
+	// The bit vector of owning or deserialized instances
+	util::Vector<uint64_t, AT> owned_bits;
+
+	void save(std::ostream &os) const {
+		util::save_bits(os, bits, num_words * 64);
+		util::save(os, log2_zeros_per_inventory);
+		util::save(os, log2_zeros_per_sub16);
+		util::save(os, log2_zeros_per_sub64);
+		util::save(os, log2_longwords_per_subinventory);
+		util::save(os, zeros_per_inventory);
+		util::save(os, zeros_per_sub16);
+		util::save(os, zeros_per_sub64);
+		util::save(os, longwords_per_subinventory);
+		util::save(os, longwords_per_inventory);
+		util::save(os, zeros_per_inventory_mask);
+		util::save(os, zeros_per_sub16_mask);
+		util::save(os, zeros_per_sub64_mask);
+		util::save(os, num_words);
+		util::save(os, inventory_size);
+		util::save(os, exact_spill_size);
+		util::save(os, num_zeros);
+		util::save(os, inventory);
+		util::save(os, exact_spill);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, owned_bits);
+		util::load(src, log2_zeros_per_inventory);
+		util::load(src, log2_zeros_per_sub16);
+		util::load(src, log2_zeros_per_sub64);
+		util::load(src, log2_longwords_per_subinventory);
+		util::load(src, zeros_per_inventory);
+		util::load(src, zeros_per_sub16);
+		util::load(src, zeros_per_sub64);
+		util::load(src, longwords_per_subinventory);
+		util::load(src, longwords_per_inventory);
+		util::load(src, zeros_per_inventory_mask);
+		util::load(src, zeros_per_sub16_mask);
+		util::load(src, zeros_per_sub64_mask);
+		util::load(src, num_words);
+		util::load(src, inventory_size);
+		util::load(src, exact_spill_size);
+		util::load(src, num_zeros);
+		util::load(src, inventory);
+		util::load(src, exact_spill);
+		bits = &owned_bits;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const SimpleSelectZero<AT> &simple_select_zero) {
+		simple_select_zero.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, SimpleSelectZero<AT> &simple_select_zero) {
+		simple_select_zero.load(is);
+		return is;
+	}
 
   public:
 	SimpleSelectZero() {}
 
+	/** Creates a new instance owning a given bit vector.
+	 *
+	 * The bit vector is moved into the new instance.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param max_log2_longwords_per_subinventory the number of words per subinventory:
+	 * a larger value yields a faster map that uses more space; typical values are between 0 and 3.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
+	 */
+	SimpleSelectZero(util::Vector<uint64_t, AT> &&bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory, const int threads = 1)
+		: SimpleSelectZero(&bits, num_bits, max_log2_longwords_per_subinventory, threads) {
+		owned_bits = std::move(bits);
+	}
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit SimpleSelectZero(util::Mapping &mapping) { load(mapping); }
+
 	/** Creates a new instance using a given bit vector.
 	 *
 	 * @param bits a bit vector of 64-bit words.
 	 * @param num_bits the length (in bits) of the bit vector.
 	 * @param max_log2_longwords_per_subinventory the number of words per subinventory:
 	 * a larger value yields a faster map that uses more space; typical values are between 0 and 3.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
 	 */
-	SimpleSelectZero(const uint64_t *const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory) : bits(bits) {
+	SimpleSelectZero(const uint64_t *const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory, const int threads = 1) : bits(bits) {
 		num_words = (num_bits + 63) / 64;
 
 		// Init rank/select structure
-		uint64_t c = 0;
-		for (uint64_t i = 0; i < num_words; i++) c += __builtin_popcountll(~bits[i]);
+		const vector<uint64_t> slice_rank = slice_ranks<true>(bits, num_bits, threads);
+		const uint64_t c = slice_rank[threads];
 		num_zeros = c;
 
-		if (num_bits % 64 != 0) c -= 64 - num_bits % 64;
 		assert(c <= num_bits);
 
 		zeros_per_inventory = num_bits == 0 ? 0 : (c * max_zeros_per_inventory + num_bits - 1) / num_bits;
@@ -105,21 +189,15 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZero {
 #endif
 
 		inventory.size(inventory_size * longwords_per_inventory + 1);
-		const int64_t *end_of_inventory = &inventory + inventory_size * longwords_per_inventory + 1;
-
-		uint64_t d = 0;
 
-		// First phase: we build an inventory for each one out of zeros_per_inventory.
-		for (uint64_t i = 0; i < num_words; i++)
-			for (int j = 0; j < 64; j++) {
-				if (i * 64 + j >= num_bits) break;
-				if (~bits[i] & 1ULL << j) {
-					if ((d & zeros_per_inventory_mask) == 0) inventory[(d >> log2_zeros_per_inventory) * longwords_per_inventory] = i * 64 + j;
-					d++;
-				}
-			}
+		// First phase: we build an inventory for each zero out of zeros_per_inventory.
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones<true>(bits, num_bits, from, to, slice_rank[t], mround(slice_rank[t], zeros_per_inventory), [&](const uint64_t d, const uint64_t pos) {
+				inventory[(d >> log2_zeros_per_inventory) * longwords_per_inventory] = pos;
+				return d + zeros_per_inventory;
+			});
+		});
 
-		assert(c == d);
 		inventory[inventory_size * longwords_per_inventory] = num_bits;
 
 #ifdef DEBUG
@@ -129,32 +207,26 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZero {
 		// If zeros_per_inventory = 1 we don't need to build subinventories;
 		// this case is managed in the selection code by a test.
 		if (zeros_per_inventory > 1) {
-			d = 0;
-			int zeros;
-			uint64_t spilled = 0, exact = 0, start, span, inventory_index;
-
-			for (uint64_t i = 0; i < num_words; i++)
-				// We estimate the subinventory and exact spill size
-				for (int j = 0; j < 64; j++) {
-					if (i * 64 + j >= num_bits) break;
-					if (~bits[i] & 1ULL << j) {
-						if ((d & zeros_per_inventory_mask) == 0) {
-							inventory_index = d >> log2_zeros_per_inventory;
-							start = inventory[inventory_index * longwords_per_inventory];
-							span = inventory[(inventory_index + 1) * longwords_per_inventory] - start;
-							zeros = min(c - d, (uint64_t)zeros_per_inventory);
-
-							assert(start + span == num_bits || zeros == zeros_per_inventory);
-
-							// We accumulate space for exact pointers ONLY if necessary.
-							if (span >= (1 << 16)) {
-								exact += zeros;
-								if (zeros_per_sub64 > 1) spilled += zeros;
-							}
-						}
-						d++;
+			uint64_t spilled = 0, exact = 0;
+
+			// We compute the exact spill size, storing in the subinventory the
+			// index of the first spilled entry of each inventory using it.
+			for (uint64_t inventory_index = 0; inventory_index < inventory_size; inventory_index++) {
+				const uint64_t start = inventory[inventory_index * longwords_per_inventory];
+				const uint64_t span = inventory[(inventory_index + 1) * longwords_per_inventory] - start;
+				const uint64_t zeros = min(c - inventory_index * zeros_per_inventory, (uint64_t)zeros_per_inventory);
+
+				assert(start + span == num_bits || zeros == (uint64_t)zeros_per_inventory);
+
+				// We accumulate space for exact pointers ONLY if necessary.
+				if (span >= (1 << 16)) {
+					exact += zeros;
+					if (zeros_per_sub64 > 1) {
+						inventory[inventory_index * longwords_per_inventory + 1] = spilled;
+						spilled += zeros;
 					}
 				}
+			}
 
 #ifdef DEBUG
 			printf("Spilled entries: %" PRId64 " exact: %" PRId64 "\n", spilled, exact);
@@ -163,52 +235,36 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZero {
 			exact_spill_size = spilled;
 			exact_spill.size(exact_spill_size);
 
-			uint16_t *p16;
-			int64_t *p64;
-			int offset;
-			spilled = 0;
-			d = 0;
-
-			for (uint64_t i = 0; i < num_words; i++)
-				for (int j = 0; j < 64; j++) {
-					if (i * 64 + j >= num_bits) break;
-					if (~bits[i] & 1ULL << j) {
-						if ((d & zeros_per_inventory_mask) == 0) {
-							inventory_index = d >> log2_zeros_per_inventory;
-							start = inventory[inventory_index * longwords_per_inventory];
-							span = inventory[(inventory_index + 1) * longwords_per_inventory] - start;
-							p64 = &inventory[inventory_index * longwords_per_inventory + 1];
-							p16 = (uint16_t *)p64;
-							offset = 0;
-						}
-
-						if (span < (1 << 16)) {
-							assert(i * 64 + j - start <= (1 << 16));
-							if ((d & zeros_per_sub16_mask) == 0) {
-								assert(offset < longwords_per_subinventory * 4);
-								assert(p16 + offset < (uint16_t *)end_of_inventory);
-								p16[offset++] = i * 64 + j - start;
-							}
-						} else {
-							if (zeros_per_sub64 == 1) {
-								assert(p64 + offset < end_of_inventory);
-								p64[offset++] = i * 64 + j;
-							} else {
-								assert(p64 < end_of_inventory);
-								if ((d & zeros_per_inventory_mask) == 0) {
-									inventory[inventory_index * longwords_per_inventory] |= 1ULL << 63;
-									p64[0] = spilled;
-								}
-								assert(spilled < exact_spill_size);
-								exact_spill[spilled++] = i * 64 + j;
-							}
-						}
-
-						d++;
+			// Second phase: we fill the subinventories and the exact spill. Each inventory
+			// is scanned only on its sampled zeros, unless its span requires exact pointers.
+			parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+				scan_ones<true>(bits, num_bits, from, to, slice_rank[t], slice_rank[t], [&](const uint64_t d, const uint64_t pos) {
+					const uint64_t inventory_index = d >> log2_zeros_per_inventory;
+					const uint64_t start = inventory[inventory_index * longwords_per_inventory];
+					const uint64_t span = inventory[(inventory_index + 1) * longwords_per_inventory] - start;
+					int64_t *const p64 = &inventory[inventory_index * longwords_per_inventory + 1];
+
+					if (span < (1 << 16)) {
+						assert(pos - start <= (1 << 16));
+						if ((d & zeros_per_sub16_mask) == 0) ((uint16_t *)p64)[(d & zeros_per_inventory_mask) >> log2_zeros_per_sub16] = pos - start;
+						return (d | zeros_per_sub16_mask) + 1;
 					}
-				}
-		}
 
+					if (zeros_per_sub64 == 1)
+						p64[d & zeros_per_inventory_mask] = pos;
+					else {
+						assert(p64[0] + (d & zeros_per_inventory_mask) < exact_spill_size);
+						exact_spill[p64[0] + (d & zeros_per_inventory_mask)] = pos;
+					}
+					return d + 1;
+				});
+			});
+
+			// Inventories using the exact spill are marked only now, as the second phase needs their start
+			for (uint64_t inventory_index = 0; inventory_index < inventory_size; inventory_index++)
+				if (zeros_per_sub64 > 1 && inventory[(inventory_index + 1) * longwords_per_inventory] - inventory[inventory_index * longwords_per_inventory] >= (1 << 16))
+					inventory[inventory_index * longwords_per_inventory] |= 1ULL << 63;
+		}
 #ifdef DEBUG
 		printf("First inventories: %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 "\n", inventory[0], inventory[1], inventory[2], inventory[3]);
 		// if ( subinventory_size > 0 ) printf("First subinventories: %016" PRIx64 " %016" PRIx64 " %016"
@@ -261,7 +317,7 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZero {
 		uint64_t word = ~bits[word_index] & -1ULL << start % 64;
 
 		for (;;) {
-			const int bit_count = __builtin_popcountll(word);
+			const int bit_count = nu(word);
 			if (residual < bit_count) break;
 			word = ~bits[++word_index];
 			residual -= bit_count;
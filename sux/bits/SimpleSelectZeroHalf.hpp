@@ -29,6 +29,8 @@
 #pragma once
 
 #include "../support/common.hpp"
+#include "../support/parallel.hpp"
+#include "../util/Mapping.hpp"
 #include "../util/Vector.hpp"
 #include "SelectZero.hpp"
 #include <cstdint>
@@ -44,10 +46,14 @@ using namespace sux;
  * The constructors of this class only store a reference
  * to a provided bit vector. Should the content of the
  * bit vector change, the results will be unpredictable.
+ * Alternatively, a bit vector can be moved into an instance
+ * as a util::Vector, as in Rank9.
  *
  * This implementation has been specifically developed to be used
  * with EliasFano.
  *
+ * Serialization and views work as in Rank9.
+ *
  * @tparam AT a type of memory allocation out of sux::util::AllocType.
  */
 
@@ -69,25 +75,76 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZeroHa
 	util::Vector<int64_t, AT> inventory;
 
 	uint64_t num_words, inventory_size, num_zeros;
+	// The bit vector of owning or deserialized instances
+	util::Vector<uint64_t, AT> owned_bits;
+
+	// EliasFano serializes the bit vector by itself
+	template <util::AllocType> friend class EliasFano;
+
+	void save_index(std::ostream &os) const {
+		util::save(os, num_words);
+		util::save(os, inventory_size);
+		util::save(os, num_zeros);
+		util::save(os, inventory);
+	}
+
+	template <typename S> void load_index(S &src, const uint64_t *const bits) {
+		util::load(src, num_words);
+		util::load(src, inventory_size);
+		util::load(src, num_zeros);
+		util::load(src, inventory);
+		this->bits = bits;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const SimpleSelectZeroHalf<AT> &simple_select_zero_half) {
+		util::save_bits(os, simple_select_zero_half.bits, simple_select_zero_half.num_words * 64);
+		simple_select_zero_half.save_index(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, SimpleSelectZeroHalf<AT> &simple_select_zero_half) {
+		util::load(is, simple_select_zero_half.owned_bits);
+		simple_select_zero_half.load_index(is, &simple_select_zero_half.owned_bits);
+		return is;
+	}
 
   public:
 	SimpleSelectZeroHalf() {}
 
+	/** Creates a new instance owning a given bit vector.
+	 *
+	 * The bit vector is moved into the new instance.
+	 *
+	 * @param bits a bit vector of 64-bit words.
+	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
+	 */
+	SimpleSelectZeroHalf(util::Vector<uint64_t, AT> &&bits, const uint64_t num_bits, const int threads = 1) : SimpleSelectZeroHalf(&bits, num_bits, threads) { owned_bits = std::move(bits); }
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit SimpleSelectZeroHalf(util::Mapping &mapping) {
+		util::load(mapping, owned_bits);
+		load_index(mapping, &owned_bits);
+	}
+
 	/** Creates a new instance using a given bit vector.
 	 *
 	 * @param bits a bit vector of 64-bit words.
 	 * @param num_bits the length (in bits) of the bit vector.
+	 * @param threads the number of threads used for construction: each thread scans a slice of the bit vector.
 	 */
 
-	SimpleSelectZeroHalf(const uint64_t *const bits, const uint64_t num_bits) : bits(bits) {
+	SimpleSelectZeroHalf(const uint64_t *const bits, const uint64_t num_bits, const int threads = 1) : bits(bits) {
 		num_words = (num_bits + 63) / 64;
 
 		// Init rank/select structure
-		uint64_t c = 0;
-		for (uint64_t i = 0; i < num_words; i++) c += __builtin_popcountll(~bits[i]);
+		const vector<uint64_t> slice_rank = slice_ranks<true>(bits, num_bits, threads);
+		const uint64_t c = slice_rank[threads];
 		num_zeros = c;
 
-		if (num_bits % 64 != 0) c -= 64 - num_bits % 64;
 		assert(c <= num_bits);
 
 		inventory_size = (c + zeros_per_inventory - 1) / zeros_per_inventory;
@@ -100,70 +157,42 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZeroHa
 
 		inventory.size(inventory_size * (longwords_per_subinventory + 1) + 1);
 
-		uint64_t d = 0;
-		const uint64_t mask = zeros_per_inventory - 1;
+		// First phase: we build an inventory for each zero out of zeros_per_inventory.
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones<true>(bits, num_bits, from, to, slice_rank[t], mround(slice_rank[t], zeros_per_inventory), [&](const uint64_t d, const uint64_t pos) {
+				inventory[(d >> log2_zeros_per_inventory) * (longwords_per_subinventory + 1)] = pos;
+				return d + zeros_per_inventory;
+			});
+		});
 
-		// First phase: we build an inventory for each one out of zeros_per_inventory.
-		for (uint64_t i = 0; i < num_words; i++)
-			for (int j = 0; j < 64; j++) {
-				if (i * 64 + j >= num_bits) break;
-				if (~bits[i] & 1ULL << j) {
-					if ((d & mask) == 0) inventory[(d >> log2_zeros_per_inventory) * (longwords_per_subinventory + 1)] = i * 64 + j;
-					d++;
-				}
-			}
-
-		assert(c == d);
 		inventory[inventory_size * (longwords_per_subinventory + 1)] = num_bits;
 
 #ifdef DEBUG
 		printf("Inventory entries filled: %" PRId64 "\n", inventory_size + 1);
 #endif
 
-		uint16_t *p16;
-		int64_t *p64;
-
-		d = 0;
-		uint64_t exact = 0, start, span, inventory_index;
-		int offset;
-
-		for (uint64_t i = 0; i < num_words; i++)
-			for (int j = 0; j < 64; j++) {
-				if (i * 64 + j >= num_bits) break;
-				if (~bits[i] & 1ULL << j) {
-					if ((d & mask) == 0) {
-						inventory_index = (d >> log2_zeros_per_inventory) * (longwords_per_subinventory + 1);
-						start = inventory[inventory_index];
-						span = inventory[inventory_index + longwords_per_subinventory + 1] - start;
-						if (span > (1 << 16)) inventory[inventory_index] = -inventory[inventory_index] - 1;
-						offset = 0;
-						p64 = &inventory[inventory_index + 1];
-						p16 = (uint16_t *)p64;
-					}
-
-					if (span < (1 << 16)) {
-						assert(i * 64 + j - start <= (1 << 16));
-						if ((d & zeros_per_sub16_mask) == 0) {
-							assert(offset < longwords_per_subinventory * 4);
-							p16[offset++] = i * 64 + j - start;
-						}
-					} else {
-						if ((d & zeros_per_sub64_mask) == 0) {
-							assert(offset < longwords_per_subinventory);
-							p64[offset++] = i * 64 + j - start;
-							exact++;
-						}
-					}
-
-					d++;
+		// Second phase: we fill the subinventories, scanning only their sampled zeros.
+		parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+			scan_ones<true>(bits, num_bits, from, to, slice_rank[t], mround(slice_rank[t], zeros_per_sub16), [&](const uint64_t d, const uint64_t pos) {
+				const uint64_t inventory_index = (d >> log2_zeros_per_inventory) * (longwords_per_subinventory + 1);
+				const uint64_t start = inventory[inventory_index];
+				const uint64_t span = inventory[inventory_index + longwords_per_subinventory + 1] - start;
+				int64_t *const p64 = &inventory[inventory_index + 1];
+
+				if (span < (1 << 16)) {
+					assert(pos - start <= (1 << 16));
+					if ((d & zeros_per_sub16_mask) == 0) ((uint16_t *)p64)[(d & zeros_per_inventory_mask) >> log2_zeros_per_sub16] = pos - start;
+					return (d | zeros_per_sub16_mask) + 1;
 				}
-			}
 
-#ifdef DEBUG
-			// printf("Exact entries: %" PRId64 "\n", exact);
-			// printf("First inventories: %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 "\n", inventory[0], inventory[1], inventory[2],
-			//       inventory[3]);
-#endif
+				if ((d & zeros_per_sub64_mask) == 0) p64[(d & zeros_per_inventory_mask) >> log2_zeros_per_sub64] = pos - start;
+				return (d | zeros_per_sub64_mask) + 1;
+			});
+		});
+
+		// Inventories with 64-bit subinventories are marked only now, as the second phase needs their start
+		for (uint64_t inventory_index = 0; inventory_index < inventory_size * (longwords_per_subinventory + 1); inventory_index += longwords_per_subinventory + 1)
+			if (inventory[inventory_index + longwords_per_subinventory + 1] - inventory[inventory_index] >= (1 << 16)) inventory[inventory_index] = -inventory[inventory_index] - 1;
 	}
 
 	uint64_t selectZero(const uint64_t rank) {
@@ -205,7 +234,7 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZeroHa
 		uint64_t word = ~bits[word_index] & -1ULL << start % 64;
 
 		for (;;) {
-			const int bit_count = __builtin_popcountll(word);
+			const int bit_count = nu(word);
 			if (residual < bit_count) break;
 			word = ~bits[++word_index];
 			residual -= bit_count;
@@ -216,9 +245,9 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZeroHa
 
 	uint64_t selectZero(const uint64_t rank, uint64_t *const next) {
 		const uint64_t s = selectZero(rank);
-		int curr = s / 64;
+		uint64_t curr = s / 64;
 
-		uint64_t window = ~bits[curr] & -1ULL << s;
+		uint64_t window = ~bits[curr] & -1ULL << s % 64;
 		window &= window - 1;
 
 		while (window == 0) window = ~bits[++curr];
@@ -227,6 +256,37 @@ template <util::AllocType AT = util::AllocType::MALLOC> class SimpleSelectZeroHa
 		return s;
 	}
 
+	/** Prefetches the inventory entry used by selectZero() for a given rank.
+	 *
+	 * This is the first stage of a batched selection.
+	 *
+	 * @param rank the rank of a zero.
+	 */
+	__inline void prefetchInventory(const uint64_t rank) const {
+		const uint64_t inventory_index = rank >> log2_zeros_per_inventory;
+		const int64_t *const inventory_start = &inventory + (inventory_index << log2_longwords_per_subinventory) + inventory_index;
+		__builtin_prefetch(inventory_start);
+		__builtin_prefetch(inventory_start + longwords_per_subinventory);
+	}
+
+	/** Prefetches the word of the bit vector where selectZero() starts searching for a given rank.
+	 *
+	 * This is the second stage of a batched selection: it reads the inventory, which should
+	 * have been prefetched by prefetchInventory().
+	 *
+	 * @param rank the rank of a zero.
+	 */
+	__inline void prefetchWord(const uint64_t rank) const {
+		const uint64_t inventory_index = rank >> log2_zeros_per_inventory;
+		const int64_t *const inventory_start = &inventory + (inventory_index << log2_longwords_per_subinventory) + inventory_index;
+		const int64_t inventory_rank = *inventory_start;
+		const int subrank = rank & zeros_per_inventory_mask;
+		if (inventory_rank >= 0)
+			__builtin_prefetch(bits + (inventory_rank + ((uint16_t *)(inventory_start + 1))[subrank >> log2_zeros_per_sub16]) / 64);
+		else
+			__builtin_prefetch(bits + (-inventory_rank - 1 + *(inventory_start + 1 + (subrank >> log2_zeros_per_sub64))) / 64);
+	}
+
 	/** Returns an estimate of the size (in bits) of this structure. */
 	size_t bitCount() const { return inventory.bitCount() - sizeof(inventory) * 8 + sizeof(*this) * 8; };
 };
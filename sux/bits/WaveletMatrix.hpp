@@ -0,0 +1,332 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "../support/parallel.hpp"
+#include "../util/Vector.hpp"
+#include "Rank9Sel.hpp"
+#include "SimpleSelectZero.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sux::bits {
+
+using namespace std;
+using namespace sux;
+
+/** A wavelet matrix over a sequence of integers.
+ *
+ * A wavelet matrix represents a sequence of _n_ integers of _w_ bits by _w_ bit vectors
+ * of _n_ bits, one per level. The bit vector of level _l_ contains the bit
+ * of index _w_ &minus; _l_ &minus; 1 of the elements of the sequence, in the order obtained
+ * by stably moving, at each previous level, the elements with a zero bit before the elements
+ * with a one bit. Each bit vector is indexed by a Rank9Sel (for ranking and selecting ones)
+ * and a SimpleSelectZero (for selecting zeroes), so all queries require a constant number of
+ * operations per level.
+ *
+ * Beside access, rank and select, wavelet matrices support range quantiles
+ * (the _k_-th smallest element in a range of positions) and range counting (the
+ * number of elements in a range of positions whose value is in a range of values).
+ *
+ * Batched versions of access and rank process a window of queries level by level,
+ * so that the cache misses of independent queries overlap.
+ *
+ * @tparam AT a type of memory allocation out of sux::util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class WaveletMatrix {
+  private:
+	size_t n = 0;
+	int width = 0;
+	// For each level, its bit vector, its number of zeroes, and the structures indexing it.
+	std::vector<util::Vector<uint64_t, AT>> levels;
+	std::vector<uint64_t> zeros;
+	std::vector<Rank9Sel<AT>> rank_select;
+	std::vector<SimpleSelectZero<AT>> select_zero;
+
+	__inline uint64_t bit(const int level, const uint64_t i) const { return levels[level][i / 64] >> i % 64 & 1; }
+
+	// The position at the next level of the element of position i at the given level, assuming its bit is b.
+	__inline uint64_t next(const int level, const uint64_t i, const uint64_t b) { return b ? zeros[level] + rank_select[level].rank(i) : i - rank_select[level].rank(i); }
+
+  public:
+	WaveletMatrix() {}
+
+	/** Creates a new instance using a given sequence.
+	 *
+	 * Note that the sequence is read only at construction time.
+	 *
+	 * @param sequence a sequence of integers.
+	 * @param width the number of bits of the elements of the sequence, or 0 to use the minimum
+	 * number of bits needed to represent the maximum element.
+	 * @param threads the number of threads used for construction: each level is built by all
+	 * threads, each working on a slice of the sequence, and then the ranking and selection
+	 * structures of the levels are built in parallel.
+	 */
+	WaveletMatrix(const std::vector<uint64_t> &sequence, int width = 0, const int threads = 1) : n(sequence.size()) {
+		if (width == 0) width = n == 0 ? 1 : max(1, lambda_safe(*max_element(sequence.begin(), sequence.end())) + 1);
+		assert(width <= 64);
+		assert(width == 64 || all_of(sequence.begin(), sequence.end(), [width](const uint64_t x) { return x >> width == 0; }));
+		this->width = width;
+
+		const uint64_t num_words = (n + 63) / 64;
+		std::vector<uint64_t> cur(sequence), nxt(n);
+		std::vector<uint64_t> slice_zeros(threads + 1), slice_ones(threads + 1);
+
+		for (int l = 0; l < width; l++) {
+			const int shift = width - l - 1;
+			// A free word makes rank(n) possible
+			util::Vector<uint64_t, AT> bits(num_words + 1);
+
+			// Slices are made of whole words, so threads write disjoint words
+			parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+				uint64_t ones = 0;
+				for (uint64_t i = from * 64; i < min(to * 64, n); i++) {
+					const uint64_t b = cur[i] >> shift & 1;
+					bits[i / 64] |= b << i % 64;
+					ones += b;
+				}
+				slice_ones[t + 1] = ones;
+				slice_zeros[t + 1] = min(to * 64, n) - min(from * 64, n) - ones;
+			});
+			for (int t = 0; t < threads; t++) {
+				slice_ones[t + 1] += slice_ones[t];
+				slice_zeros[t + 1] += slice_zeros[t];
+			}
+			zeros.push_back(slice_zeros[threads]);
+
+			// Stable partition: zeroes first, then ones
+			parallel_slices(num_words, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+				uint64_t z = slice_zeros[t], o = zeros[l] + slice_ones[t];
+				for (uint64_t i = from * 64; i < min(to * 64, n); i++) nxt[bits[i / 64] >> i % 64 & 1 ? o++ : z++] = cur[i];
+			});
+			cur.swap(nxt);
+			levels.push_back(std::move(bits));
+		}
+
+		rank_select.resize(width);
+		select_zero.resize(width);
+		parallel_slices(width, threads, [&](const int, const uint64_t from, const uint64_t to) {
+			for (uint64_t l = from; l < to; l++) {
+				rank_select[l] = Rank9Sel<AT>(&levels[l], n);
+				select_zero[l] = SimpleSelectZero<AT>(&levels[l], n, 3);
+			}
+		});
+	}
+
+	/** Returns the element of given position.
+	 *
+	 * @param i a position from 0 to size() (excluded).
+	 * @return the element of position `i`.
+	 */
+	uint64_t access(uint64_t i) {
+		assert(i < n);
+		uint64_t c = 0;
+		for (int l = 0; l < width; l++) {
+			const uint64_t b = bit(l, i);
+			c = c << 1 | b;
+			i = next(l, i, b);
+		}
+		return c;
+	}
+
+	/** Returns the number of occurrences of an element before a given position.
+	 *
+	 * @param c an element.
+	 * @param i a position from 0 to size() (included).
+	 * @return the number of occurrences of `c` in the positions before `i`.
+	 */
+	uint64_t rank(const uint64_t c, uint64_t i) {
+		assert(i <= n);
+		if (width < 64 && c >> width != 0) return 0;
+		uint64_t s = 0;
+		for (int l = 0; l < width; l++) {
+			const uint64_t b = c >> (width - l - 1) & 1;
+			s = next(l, s, b);
+			i = next(l, i, b);
+		}
+		return i - s;
+	}
+
+	/** Returns the position of the occurrence of an element of given rank.
+	 *
+	 * @param c an element.
+	 * @param k a rank from 0 to `rank(c, size())` (excluded).
+	 * @return the position of the occurrence of `c` of rank `k`.
+	 */
+	uint64_t select(const uint64_t c, const uint64_t k) {
+		// Find the start of the positions of c at the last level
+		uint64_t s = 0;
+		for (int l = 0; l < width; l++) s = next(l, s, c >> (width - l - 1) & 1);
+
+		uint64_t i = s + k;
+		for (int l = width; l-- != 0;) {
+			if (c >> (width - l - 1) & 1)
+				i = rank_select[l].select(i - zeros[l]);
+			else
+				i = select_zero[l].selectZero(i);
+		}
+		assert(i < n);
+		return i;
+	}
+
+	/** Returns the element of given rank among those in a range of positions.
+	 *
+	 * @param from the first position of the range.
+	 * @param to the position after the last position of the range, larger than `from` and at most size().
+	 * @param k a rank from 0 to `to` &minus; `from` (excluded).
+	 * @return the element of rank `k` (i.e., the `k`+1-th smallest element, counting repetitions)
+	 * among those at positions from `from` (included) to `to` (excluded).
+	 */
+	uint64_t quantile(uint64_t from, uint64_t to, uint64_t k) {
+		assert(from < to && to <= n);
+		assert(k < to - from);
+		uint64_t c = 0;
+		for (int l = 0; l < width; l++) {
+			const uint64_t rank_from = rank_select[l].rank(from), rank_to = rank_select[l].rank(to);
+			const uint64_t z = (to - rank_to) - (from - rank_from);
+			if (k < z) {
+				c <<= 1;
+				from -= rank_from;
+				to -= rank_to;
+			} else {
+				c = c << 1 | 1;
+				k -= z;
+				from = zeros[l] + rank_from;
+				to = zeros[l] + rank_to;
+			}
+		}
+		return c;
+	}
+
+	/** Returns the number of elements smaller than a given value in a range of positions.
+	 *
+	 * @param from the first position of the range.
+	 * @param to the position after the last position of the range, at least `from` and at most size().
+	 * @param value a value.
+	 * @return the number of elements smaller than `value` among those at positions from `from` (included) to `to` (excluded).
+	 */
+	uint64_t countLess(uint64_t from, uint64_t to, const uint64_t value) {
+		assert(from <= to && to <= n);
+		if (width < 64 && value >> width != 0) return to - from;
+		uint64_t count = 0;
+		for (int l = 0; l < width && from < to; l++) {
+			const uint64_t rank_from = rank_select[l].rank(from), rank_to = rank_select[l].rank(to);
+			if (value >> (width - l - 1) & 1) {
+				count += (to - rank_to) - (from - rank_from);
+				from = zeros[l] + rank_from;
+				to = zeros[l] + rank_to;
+			} else {
+				from -= rank_from;
+				to -= rank_to;
+			}
+		}
+		return count;
+	}
+
+	/** Returns the number of elements in a range of values in a range of positions.
+	 *
+	 * @param from the first position of the range.
+	 * @param to the position after the last position of the range, at least `from` and at most size().
+	 * @param min the minimum value (included).
+	 * @param max the maximum value (excluded).
+	 * @return the number of elements at least `min` and smaller than `max` among those at positions from `from` (included) to `to` (excluded).
+	 */
+	uint64_t rangeCount(const uint64_t from, const uint64_t to, const uint64_t min, const uint64_t max) {
+		if (min >= max) return 0;
+		return countLess(from, to, max) - countLess(from, to, min);
+	}
+
+	/** Computes the elements at a batch of positions.
+	 *
+	 * Positions are processed in windows of ::BATCH_WINDOW queries, level by level: at each level,
+	 * the words and the counts needed by all queries in a window are prefetched before
+	 * moving the queries to the next level, so that the cache misses of independent queries overlap.
+	 *
+	 * @param pos an array of `n` positions, each from 0 to size() (excluded).
+	 * @param out an array of `n` elements that will contain the elements at the positions in `pos`.
+	 * @param n the number of positions.
+	 */
+	void access(const uint64_t *const pos, uint64_t *const out, const size_t n) {
+		uint64_t i[BATCH_WINDOW], r[BATCH_WINDOW];
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t m = std::min(n - b, size_t(BATCH_WINDOW));
+			std::copy(pos + b, pos + b + m, i);
+			std::fill(out + b, out + b + m, 0);
+			for (int l = 0; l < width; l++) {
+				rank_select[l].rank(i, r, m);
+				for (size_t j = 0; j < m; j++) {
+					const uint64_t bb = bit(l, i[j]);
+					out[b + j] = out[b + j] << 1 | bb;
+					i[j] = bb ? zeros[l] + r[j] : i[j] - r[j];
+				}
+			}
+		}
+	}
+
+	/** Computes the ranks of a batch of elements and positions.
+	 *
+	 * Queries are processed as in access(const uint64_t *, uint64_t *, size_t).
+	 *
+	 * @param c an array of `n` elements.
+	 * @param pos an array of `n` positions, each from 0 to size() (included).
+	 * @param out an array of `n` elements that will contain the number of occurrences of each
+	 * element of `c` before the corresponding position in `pos`.
+	 * @param n the number of queries.
+	 */
+	void rank(const uint64_t *const c, const uint64_t *const pos, uint64_t *const out, const size_t n) {
+		// Starts and positions, interleaved
+		uint64_t q[2 * BATCH_WINDOW], r[2 * BATCH_WINDOW];
+		for (size_t b = 0; b < n; b += BATCH_WINDOW) {
+			const size_t m = std::min(n - b, size_t(BATCH_WINDOW));
+			for (size_t j = 0; j < m; j++) {
+				q[2 * j] = 0;
+				q[2 * j + 1] = width < 64 && c[b + j] >> width != 0 ? 0 : pos[b + j];
+			}
+			for (int l = 0; l < width; l++) {
+				rank_select[l].rank(q, r, 2 * m);
+				for (size_t j = 0; j < 2 * m; j++) q[j] = c[b + j / 2] >> (width - l - 1) & 1 ? zeros[l] + r[j] : q[j] - r[j];
+			}
+			for (size_t j = 0; j < m; j++) out[b + j] = width < 64 && c[b + j] >> width != 0 ? 0 : q[2 * j + 1] - q[2 * j];
+		}
+	}
+
+	/** Returns the length of the sequence. */
+	size_t size() const { return n; }
+
+	/** Returns the number of bits of the elements of the sequence. */
+	int getWidth() const { return width; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const {
+		size_t bits = sizeof(*this) * 8 + zeros.capacity() * sizeof(uint64_t) * 8;
+		for (int l = 0; l < width; l++) bits += levels[l].bitCount() + rank_select[l].bitCount() + select_zero[l].bitCount();
+		return bits;
+	}
+};
+
+} // namespace sux::bits
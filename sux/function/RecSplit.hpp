@@ -433,6 +433,25 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 	 */
 	size_t operator()(const string &key) { return operator()(first_hash(key.c_str(), key.size())); }
 
+	/** Decodes all splitting and bijection codes of a bucket, in preorder.
+	 *
+	 * This method is mainly useful for computing statistics.
+	 * @param bucket a bucket index.
+	 * @param out a vector that will be filled with the codes of the bucket.
+	 */
+	void decodeAll(const size_t bucket, vector<uint64_t> &out) {
+		uint64_t cum_keys, cum_keys_next, bit_pos;
+		ef.get(bucket, cum_keys, cum_keys_next, bit_pos);
+
+		vector<uint8_t> log2golombs;
+		golombParams(cum_keys_next - cum_keys, log2golombs);
+		out.resize(log2golombs.size());
+		descriptors.decodeAll(bit_pos, log2golombs.data(), log2golombs.size(), out.data());
+	}
+
+	/** Returns the number of buckets of this RecSplit instance. */
+	inline size_t buckets() { return this->nbuckets; }
+
 	/** Returns the number of keys used to build this RecSplit instance. */
 	inline size_t size() { return this->keys_count; }
 
@@ -442,14 +461,33 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 	// Maps a 128-bit to a bucket using the first 64-bit half.
 	inline uint64_t hash128_to_bucket(const hash128_t &hash) const { return remap128(hash.first, nbuckets); }
 
-	// Computes and stores the splittings and bijections of a bucket.
-	void recSplit(vector<uint64_t> &bucket, typename RiceBitVector<AT>::Builder &builder, vector<uint32_t> &unary) {
+	// Computes the Golomb-Rice parameters of the nodes of a subtree of size m, in preorder.
+	void golombParams(const size_t m, vector<uint8_t> &log2golombs) {
+		if (m <= 1) return;
+		log2golombs.push_back(golomb_param(m));
+		if (m <= _leaf) return;
+
+		if (m > upper_aggr) { // fanout = 2
+			const size_t split = ((uint16_t(m / 2 + upper_aggr - 1) / upper_aggr)) * upper_aggr;
+			golombParams(split, log2golombs);
+			golombParams(m - split, log2golombs);
+		} else {
+			const size_t unit = m > lower_aggr ? lower_aggr : _leaf;
+			size_t i;
+			for (i = 0; i < m - unit; i += unit) golombParams(unit, log2golombs);
+			golombParams(m - i, log2golombs);
+		}
+	}
+
+	// Computes the splittings and bijections of a bucket, accumulating their codes
+	// and Golomb-Rice parameters in preorder.
+	void recSplit(vector<uint64_t> &bucket, vector<uint64_t> &codes, vector<uint8_t> &log2golombs) {
 		const auto m = bucket.size();
 		vector<uint64_t> temp(m);
-		recSplit(bucket, temp, 0, bucket.size(), builder, unary, 0);
+		recSplit(bucket, temp, 0, bucket.size(), codes, log2golombs, 0);
 	}
 
-	void recSplit(vector<uint64_t> &bucket, vector<uint64_t> &temp, size_t start, size_t end, typename RiceBitVector<AT>::Builder &builder, vector<uint32_t> &unary, const int level) {
+	void recSplit(vector<uint64_t> &bucket, vector<uint64_t> &temp, size_t start, size_t end, vector<uint64_t> &codes, vector<uint8_t> &log2golombs, const int level) {
 		const auto m = end - start;
 		assert(m > 1);
 		uint64_t x = start_seed[level];
@@ -495,8 +533,8 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 #endif
 			x -= start_seed[level];
 			const auto log2golomb = golomb_param(m);
-			builder.appendFixed(x, log2golomb);
-			unary.push_back(x >> log2golomb);
+			codes.push_back(x);
+			log2golombs.push_back(log2golomb);
 #ifdef MORESTATS
 			bij_count[m]++;
 			num_bij_trials[m] += x + 1;
@@ -540,14 +578,14 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 				copy(&temp[0], &temp[m], &bucket[start]);
 				x -= start_seed[level];
 				const auto log2golomb = golomb_param(m);
-				builder.appendFixed(x, log2golomb);
-				unary.push_back(x >> log2golomb);
+				codes.push_back(x);
+				log2golombs.push_back(log2golomb);
 
 #ifdef MORESTATS
 				time_split[min(MAX_LEVEL_TIME, level)] += duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
 #endif
-				recSplit(bucket, temp, start, start + split, builder, unary, level + 1);
-				if (m - split > 1) recSplit(bucket, temp, start + split, end, builder, unary, level + 1);
+				recSplit(bucket, temp, start, start + split, codes, log2golombs, level + 1);
+				if (m - split > 1) recSplit(bucket, temp, start + split, end, codes, log2golombs, level + 1);
 #ifdef MORESTATS
 				else
 					sum_depths += level;
@@ -577,17 +615,17 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 
 				x -= start_seed[level];
 				const auto log2golomb = golomb_param(m);
-				builder.appendFixed(x, log2golomb);
-				unary.push_back(x >> log2golomb);
+				codes.push_back(x);
+				log2golombs.push_back(log2golomb);
 
 #ifdef MORESTATS
 				time_split[min(MAX_LEVEL_TIME, level)] += duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
 #endif
 				size_t i;
 				for (i = 0; i < m - lower_aggr; i += lower_aggr) {
-					recSplit(bucket, temp, start + i, start + i + lower_aggr, builder, unary, level + 1);
+					recSplit(bucket, temp, start + i, start + i + lower_aggr, codes, log2golombs, level + 1);
 				}
-				if (m - i > 1) recSplit(bucket, temp, start + i, end, builder, unary, level + 1);
+				if (m - i > 1) recSplit(bucket, temp, start + i, end, codes, log2golombs, level + 1);
 #ifdef MORESTATS
 				else
 					sum_depths += level;
@@ -616,17 +654,17 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 
 				x -= start_seed[level];
 				const auto log2golomb = golomb_param(m);
-				builder.appendFixed(x, log2golomb);
-				unary.push_back(x >> log2golomb);
+				codes.push_back(x);
+				log2golombs.push_back(log2golomb);
 
 #ifdef MORESTATS
 				time_split[min(MAX_LEVEL_TIME, level)] += duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count();
 #endif
 				size_t i;
 				for (i = 0; i < m - _leaf; i += _leaf) {
-					recSplit(bucket, temp, start + i, start + i + _leaf, builder, unary, level + 1);
+					recSplit(bucket, temp, start + i, start + i + _leaf, codes, log2golombs, level + 1);
 				}
-				if (m - i > 1) recSplit(bucket, temp, start + i, end, builder, unary, level + 1);
+				if (m - i > 1) recSplit(bucket, temp, start + i, end, codes, log2golombs, level + 1);
 #ifdef MORESTATS
 				else
 					sum_depths += level;
@@ -692,6 +730,11 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 
 		sort(hashes, hashes + keys_count, [this](const hash128_t &a, const hash128_t &b) { return hash128_to_bucket(a) < hash128_to_bucket(b); });
 		typename RiceBitVector<AT>::Builder builder;
+		// Estimate: exact fixed parts of an average bucket, and about two bits per unary part
+		const size_t avg_bucket = min(bucket_size, MAX_BUCKET_SIZE - 1);
+		builder.reserve(nbuckets * (skip_bits(avg_bucket) + 2 * skip_nodes(avg_bucket)));
+		vector<uint64_t> codes;
+		vector<uint8_t> log2golombs;
 
 		bucket_size_acc[0] = bucket_pos_acc[0] = 0;
 		for (size_t i = 0, last = 0; i < nbuckets; i++) {
@@ -701,9 +744,10 @@ template <size_t LEAF_SIZE, util::AllocType AT = util::AllocType::MALLOC> class
 			const size_t s = bucket.size();
 			bucket_size_acc[i + 1] = bucket_size_acc[i] + s;
 			if (bucket.size() > 1) {
-				vector<uint32_t> unary;
-				recSplit(bucket, builder, unary);
-				builder.appendUnaryAll(unary);
+				codes.clear();
+				log2golombs.clear();
+				recSplit(bucket, codes, log2golombs);
+				builder.appendBucket(codes.data(), log2golombs.data(), codes.size());
 			}
 			bucket_pos_acc[i + 1] = builder.getBits();
 #ifdef MORESTATS
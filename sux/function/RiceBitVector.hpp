@@ -33,6 +33,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
+#include <vector>
 
 namespace sux::function {
 
@@ -48,20 +49,87 @@ using namespace sux;
 template <util::AllocType AT = util::AllocType::MALLOC> class RiceBitVector {
 
   public:
+	/** A builder for RiceBitVector instances.
+	 *
+	 * Codes of a bucket are stored as a sequence of fixed parts followed
+	 * by the sequence of the corresponding unary parts. The builder keeps
+	 * the invariant that all bits after the last appended one are zero,
+	 * so codes can be OR-ed in a word at a time.
+	 */
 	class Builder {
 		util::Vector<uint64_t, AT> data;
 		size_t bit_count = 0;
 
+		// Number of words necessary to store the given number of bits, plus a padding of
+		// seven bytes for the unaligned reads of the fixed parts performed by Reader.
+		static size_t words_for(const size_t bits) { return (((bits + 7) / 8) + 7 + 7) / 8; }
+
+		// Makes room for the given number of bits, preserving the zero-after-the-end invariant.
+		void ensure(const size_t bits) {
+			const size_t words = words_for(bits);
+			if (words > data.size()) data.resize(words);
+		}
+
+		template <typename L> void append(const uint64_t *const codes, const size_t n, const L &log2golomb) {
+			size_t fixed_bits = 0, unary_bits = 0;
+			for (size_t i = 0; i < n; i++) {
+				fixed_bits += log2golomb(i);
+				unary_bits += (codes[i] >> log2golomb(i)) + 1;
+			}
+
+			ensure(bit_count + fixed_bits + unary_bits);
+
+			uint64_t *append_ptr = &data + bit_count / 64;
+			uint64_t cur_word = *append_ptr;
+			size_t used_bits = bit_count & 63;
+
+			for (size_t i = 0; i < n; i++) {
+				const int len = log2golomb(i);
+				const uint64_t lower_bits = codes[i] & ((uint64_t(1) << len) - 1);
+				cur_word |= lower_bits << used_bits;
+				used_bits += len;
+				if (used_bits >= 64) {
+					*(append_ptr++) = cur_word;
+					used_bits -= 64;
+					cur_word = used_bits == 0 ? 0 : lower_bits >> (len - used_bits);
+				}
+			}
+
+			for (size_t i = 0; i < n; i++) {
+				used_bits += codes[i] >> log2golomb(i);
+				while (used_bits >= 64) {
+					*(append_ptr++) = cur_word;
+					cur_word = 0;
+					used_bits -= 64;
+				}
+				cur_word |= uint64_t(1) << used_bits++;
+				if (used_bits == 64) {
+					*(append_ptr++) = cur_word;
+					cur_word = 0;
+					used_bits = 0;
+				}
+			}
+
+			*append_ptr = cur_word;
+			bit_count += fixed_bits + unary_bits;
+		}
+
 	  public:
 		Builder() : Builder(16) {}
 
 		Builder(const size_t alloc_words) : data(alloc_words) {}
 
+		/** Ensures that the builder can store the given number of bits without reallocating.
+		 *
+		 * @param bits an estimate of the total number of bits that will be appended.
+		 */
+		void reserve(const size_t bits) { data.reserve(words_for(bits)); }
+
 		void appendFixed(const uint64_t v, const int log2golomb) {
 			const uint64_t lower_bits = v & ((uint64_t(1) << log2golomb) - 1);
 			int used_bits = bit_count & 63;
 
-			data.resize((((bit_count + log2golomb + 7) / 8) + 7 + 7) / 8);
+			ensure(bit_count + log2golomb);
 
 			uint64_t *append_ptr = &data + bit_count / 64;
 			uint64_t cur_word = *append_ptr;
@@ -76,25 +144,70 @@ template <util::AllocType AT = util::AllocType::MALLOC> class RiceBitVector {
 			bit_count += log2golomb;
 		}
 
-		void appendUnaryAll(const std::vector<uint32_t> unary) {
+		/** Appends the unary parts of a sequence of codes.
+		 *
+		 * @param unary the unary parts (i.e., the codes shifted right by their Golomb-Rice parameter).
+		 * @param n the number of elements of `unary`.
+		 */
+		void appendUnaryAll(const uint32_t *const unary, const size_t n) {
 			size_t bit_inc = 0;
-			for (const auto &u : unary) {
-				bit_inc += u + 1;
-			}
+			for (size_t i = 0; i < n; i++) bit_inc += unary[i] + 1;
 
-			data.resize((((bit_count + bit_inc + 7) / 8) + 7 + 7) / 8);
+			ensure(bit_count + bit_inc);
 
-			for (const auto &u : unary) {
-				bit_count += u;
-				uint64_t *append_ptr = &data + bit_count / 64;
-				*append_ptr |= uint64_t(1) << (bit_count & 63);
-				++bit_count;
+			uint64_t *append_ptr = &data + bit_count / 64;
+			uint64_t cur_word = *append_ptr;
+			size_t used_bits = bit_count & 63;
+
+			for (size_t i = 0; i < n; i++) {
+				used_bits += unary[i];
+				while (used_bits >= 64) {
+					*(append_ptr++) = cur_word;
+					cur_word = 0;
+					used_bits -= 64;
+				}
+				cur_word |= uint64_t(1) << used_bits++;
+				if (used_bits == 64) {
+					*(append_ptr++) = cur_word;
+					cur_word = 0;
+					used_bits = 0;
+				}
 			}
+
+			*append_ptr = cur_word;
+			bit_count += bit_inc;
+		}
+
+		void appendUnaryAll(const std::vector<uint32_t> &unary) { appendUnaryAll(unary.data(), unary.size()); }
+
+		/** Appends all codes of a bucket in a single pass.
+		 *
+		 * The result is the same as calling appendFixed() on each code, followed by
+		 * a call to appendUnaryAll() on the unary parts, but words are written
+		 * just once and storage is resized just once.
+		 *
+		 * @param codes the codes of the bucket.
+		 * @param log2golomb the Golomb-Rice parameter of each code.
+		 * @param n the number of codes.
+		 */
+		void appendBucket(const uint64_t *const codes, const uint8_t *const log2golomb, const size_t n) {
+			append(codes, n, [log2golomb](const size_t i) { return int(log2golomb[i]); });
+		}
+
+		/** Appends all codes of a bucket sharing the same Golomb-Rice parameter in a single pass.
+		 *
+		 * @param codes the codes of the bucket.
+		 * @param log2golomb the Golomb-Rice parameter of all codes.
+		 * @param n the number of codes.
+		 */
+		void appendBucket(const uint64_t *const codes, const int log2golomb, const size_t n) {
+			append(codes, n, [log2golomb](const size_t) { return log2golomb; });
 		}
 
 		uint64_t getBits() { return bit_count; }
 
 		RiceBitVector<AT> build() {
+			data.resize(words_for(bit_count));
 			data.trimToFit();
 			return RiceBitVector(std::move(data));
 		}
@@ -103,6 +216,39 @@ template <util::AllocType AT = util::AllocType::MALLOC> class RiceBitVector {
   private:
 	util::Vector<uint64_t, AT> data;
 
+	// Reads the fixed part of length len starting at bit pos.
+	uint64_t fixedAt(const size_t pos, const int len) const {
+		uint64_t fixed;
+		memcpy(&fixed, (uint8_t *)&data + pos / 8, 8);
+#ifdef __BMI2__
+		return _bzhi_u64(fixed >> pos % 8, len);
+#else
+		return (fixed >> pos % 8) & ((uint64_t(1) << len) - 1);
+#endif
+	}
+
+	// Decodes n consecutive unary parts starting at bit unary_pos. Each word
+	// is consumed by enumerating its set bits, so all codes ending in the
+	// same word are decoded by a single branch-free inner loop.
+	void decodeUnary(const size_t unary_pos, const size_t n, uint64_t *const out) const {
+		const uint64_t *ptr = &data + unary_pos / 64;
+		uint64_t window = *ptr++ & -1ULL << unary_pos % 64;
+		size_t word_pos = unary_pos & ~size_t(63), prev = unary_pos;
+
+		for (size_t i = 0; i < n;) {
+			while (window == 0) {
+				window = *ptr++;
+				word_pos += 64;
+			}
+			do {
+				const size_t end = word_pos + rho(window);
+				out[i++] = end - prev;
+				prev = end + 1;
+				window = clear_rho(window);
+			} while (window != 0 && i < n);
+		}
+	}
+
 	friend std::ostream &operator<<(std::ostream &os, const RiceBitVector<AT> &rbv) {
 		os << rbv.data;
 		return os;
@@ -119,6 +265,41 @@ template <util::AllocType AT = util::AllocType::MALLOC> class RiceBitVector {
 
 	size_t getBits() const { return data.size() * sizeof(uint64_t) * 8; }
 
+	/** Decodes a sequence of consecutive codes stored as in a RecSplit bucket.
+	 *
+	 * The fixed parts start at `bit_pos` and are followed by the unary parts.
+	 * Unary parts are decoded first, a word at a time, and then the fixed
+	 * parts are merged in with one unaligned read per code. This is
+	 * much faster than repeated calls to Reader::readNext().
+	 *
+	 * @param bit_pos the position of the first fixed part.
+	 * @param log2golomb the Golomb-Rice parameter of each code.
+	 * @param n the number of codes.
+	 * @param out an array of at least `n` elements that will be filled with the codes.
+	 */
+	void decodeAll(const size_t bit_pos, const uint8_t *const log2golomb, const size_t n, uint64_t *const out) const {
+		size_t fixed_len = 0;
+		for (size_t i = 0; i < n; i++) fixed_len += log2golomb[i];
+
+		decodeUnary(bit_pos + fixed_len, n, out);
+
+		for (size_t i = 0, fixed_offset = bit_pos; i < n; fixed_offset += log2golomb[i++]) out[i] = out[i] << log2golomb[i] | fixedAt(fixed_offset, log2golomb[i]);
+	}
+
+	/** Decodes a sequence of consecutive codes sharing the same Golomb-Rice parameter.
+	 *
+	 * @param bit_pos the position of the first fixed part.
+	 * @param log2golomb the Golomb-Rice parameter of all codes.
+	 * @param n the number of codes.
+	 * @param out an array of at least `n` elements that will be filled with the codes.
+	 * @see decodeAll(size_t, const uint8_t *, size_t, uint64_t *)
+	 */
+	void decodeAll(const size_t bit_pos, const int log2golomb, const size_t n, uint64_t *const out) const {
+		decodeUnary(bit_pos + n * log2golomb, n, out);
+
+		for (size_t i = 0, fixed_offset = bit_pos; i < n; i++, fixed_offset += log2golomb) out[i] = out[i] << log2golomb | fixedAt(fixed_offset, log2golomb);
+	}
+
 	class Reader {
 		size_t curr_fixed_offset = 0;
 		uint64_t curr_window_unary = 0;
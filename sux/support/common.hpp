@@ -36,6 +36,7 @@
 #include <memory>
 
 #if defined(__x86_64__)
+#include <cpuid.h>
 #include <x86intrin.h>
 #endif
 
@@ -99,6 +100,9 @@ using auint8_t = std::uint8_t __attribute__((__may_alias__));
 // Bitmask array used in util::FenwickByteL and util::FenwickByteF
 static constexpr uint64_t BYTE_MASK[] = {0x0ULL, 0xFFULL, 0xFFFFULL, 0xFFFFFFULL, 0xFFFFFFFFULL, 0xFFFFFFFFFFULL, 0xFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL};
 
+// Number of queries processed together by the batched rank/select methods of the classes in sux::bits
+static constexpr size_t BATCH_WINDOW = 32;
+
 /** Static (i.e. computed in compile time) 1 + log2 rounded up. */
 constexpr size_t ceil_log2_plus1(size_t n) { return ((n < 2) ? 1 : 1 + ceil_log2_plus1(n / 2)); }
 
@@ -335,11 +339,64 @@ inline void bitwrite_inc(void *const word, int from, int length, uint64_t inc) {
 	}
 }
 
+/** The features of the CPU that select at runtime the implementation of some kernels.
+ *
+ * Features are detected once, at startup, so that a single binary can use the
+ * best instructions available on the host. All features are false
+ * before detection (e.g., during the static initialization of other translation
+ * units) and on non-x86 platforms, in which case portable code is used.
+ */
+struct CpuFeatures {
+	/** Whether the `popcnt` instruction is available. */
+	bool popcnt = false;
+	/** Whether the BMI2 instructions are available. */
+	bool bmi2 = false;
+	/** Whether `pdep` is available and fast: it is microcoded on AMD processors before Zen 3. */
+	bool fast_pdep = false;
+	/** Whether the AVX-512 population-count instructions are available. */
+	bool avx512_vpopcntdq = false;
+	/** Whether the AVX2 instructions are available. */
+	bool avx2 = false;
+};
+
+inline CpuFeatures detect_cpu_features() {
+	CpuFeatures features;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	features.popcnt = __builtin_cpu_supports("popcnt");
+	features.bmi2 = __builtin_cpu_supports("bmi2");
+	features.avx512_vpopcntdq = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+	features.avx2 = __builtin_cpu_supports("avx2");
+
+	unsigned int eax, ebx, ecx, edx;
+	bool slow_pdep = false;
+	// Vendor "AuthenticAMD" and family (base plus extended) before 19h
+	if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) && ebx == 0x68747541 && ecx == 0x444d4163 && edx == 0x69746e65 && __get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		slow_pdep = ((eax >> 8) & 0xF) + ((eax >> 20) & 0xFF) < 0x19;
+	features.fast_pdep = features.bmi2 && !slow_pdep;
+#endif
+	return features;
+}
+
+/** The features of the CPU we are running on. */
+inline const CpuFeatures cpu_features = detect_cpu_features();
+
 /** Count the number of 1-bits in a word.
  * @param word binary word.
  *
+ * Unless the code is compiled for a target with `popcnt`, the instruction is used
+ * when available on the host (see ::cpu_features), as the fallback is very slow.
  */
-inline int nu(uint64_t word) { return __builtin_popcountll(word); }
+inline int nu(uint64_t word) {
+#if !defined(__POPCNT__) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	if (likely(cpu_features.popcnt)) {
+		uint64_t result;
+		asm("popcnt %1, %0" : "=r"(result) : "r"(word));
+		return result;
+	}
+#endif
+	return __builtin_popcountll(word);
+}
 
 /** Return a number rounded to the desired power of two multiple.
  * @param number value to round up.
@@ -374,8 +431,7 @@ inline size_t updroot(size_t j, size_t n) { return n & (SIZE_MAX << lambda((j ^
  * Long.trailingZeros(geqKStep8) has been replaced with nu(geqKStep8)
  * following a suggestion by Giuseppe Ottaviano.
  */
-inline uint64_t select64(uint64_t x, uint64_t k) {
-#ifndef __BMI2__
+inline uint64_t select64_broadword(uint64_t x, uint64_t k) {
 	constexpr uint64_t kOnesStep4 = 0x1111111111111111ULL;
 	constexpr uint64_t kOnesStep8 = 0x0101010101010101ULL;
 	constexpr uint64_t kLAMBDAsStep8 = 0x80ULL * kOnesStep8;
@@ -391,18 +447,34 @@ inline uint64_t select64(uint64_t x, uint64_t k) {
 	uint64_t place = nu(geqKStep8) * 8;
 	uint64_t byteRank = k - (((byteSums << 8) >> place) & uint64_t(0xFF));
 	return place + kSelectInByte[((x >> place) & 0xFF) | (byteRank << 8)];
-#elif defined(__GNUC__) || defined(__clang__)
-	// GCC and Clang won't inline the intrinsics.
-	uint64_t result = uint64_t(1) << k;
+}
 
-	asm("pdep %1, %0, %0\n\t"
-		"tzcnt %0, %0"
-		: "+r"(result)
-		: "r"(x));
+/** Returns the index of the k-th 1-bit in the 64-bit word x.
+ * @param x 64-bit word.
+ * @param k 0-based rank (`k = 0` returns the position of the first 1-bit).
+ *
+ * With GCC and Clang on x86-64, `pdep` is used if it is available and fast on
+ * the host (see ::cpu_features), independently of the compilation target;
+ * otherwise, select64_broadword() is used.
+ */
+inline uint64_t select64(uint64_t x, uint64_t k) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	if (likely(cpu_features.fast_pdep)) {
+		// GCC and Clang won't inline the intrinsics, and the assembler does not need -mbmi2.
+		uint64_t result = uint64_t(1) << k;
 
-	return result;
-#else
+		asm("pdep %1, %0, %0\n\t"
+			"tzcnt %0, %0"
+			: "+r"(result)
+			: "r"(x));
+
+		return result;
+	}
+	return select64_broadword(x, k);
+#elif defined(__BMI2__)
 	return _tzcnt_u64(_pdep_u64(1ULL << k, x));
+#else
+	return select64_broadword(x, k);
 #endif
 }
 
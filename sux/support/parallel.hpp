@@ -0,0 +1,127 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common.hpp"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace sux {
+
+/** Returns the start of a slice of a range.
+ *
+ * The range [0..n) is divided in `threads` contiguous slices
+ * whose lengths differ at most by one.
+ *
+ * @param n the length of the range.
+ * @param threads the number of slices.
+ * @param t the index of a slice, from 0 to `threads` (included).
+ * @return the start of slice `t`, or `n` if `t` is `threads`.
+ */
+inline uint64_t slice_begin(const uint64_t n, const int threads, const int t) { return n / threads * t + std::min(uint64_t(t), n % threads); }
+
+/** Applies a function to the slices of a range in parallel.
+ *
+ * The function is called with arguments `t`, `from` and `to`, where
+ * [`from`..`to`) is the `t`-th slice of [0..n), as defined by slice_begin().
+ * If `threads` is one, the function is called in the current thread.
+ *
+ * @param n the length of the range.
+ * @param threads the number of threads.
+ * @param f the function to apply.
+ */
+template <typename F> void parallel_slices(const uint64_t n, const int threads, F &&f) {
+	if (threads <= 1) {
+		f(0, uint64_t(0), n);
+		return;
+	}
+
+	std::vector<std::thread> pool;
+	for (int t = 0; t < threads; t++) pool.emplace_back([&f, t, n, threads] { f(t, slice_begin(n, threads, t), slice_begin(n, threads, t + 1)); });
+	for (auto &thread : pool) thread.join();
+}
+
+/** Returns a word of a bit vector, possibly complemented, with the bits beyond the end of the vector cleared.
+ *
+ * @tparam ZERO whether to complement the word.
+ * @param bits a bit vector of 64-bit words.
+ * @param num_bits the length (in bits) of the bit vector.
+ * @param i the index of a word.
+ */
+template <bool ZERO = false> __inline uint64_t scan_word(const uint64_t *const bits, const uint64_t num_bits, const uint64_t i) {
+	const uint64_t word = ZERO ? ~bits[i] : bits[i];
+	return (i + 1) * 64 <= num_bits ? word : word & ((1ULL << num_bits % 64) - 1);
+}
+
+/** Scans a range of words of a bit vector, calling a function on the ones of given ranks.
+ *
+ * The function is called with the rank and the position of a one, and it must return
+ * the rank of the next one on which it must be called, which must be larger. Words
+ * not containing such a one are skipped using just a population count.
+ *
+ * @tparam ZERO whether to scan the zeroes instead of the ones.
+ * @param bits a bit vector of 64-bit words.
+ * @param num_bits the length (in bits) of the bit vector.
+ * @param from the index of the first word to scan.
+ * @param to the index of the word after the last word to scan.
+ * @param rank the number of ones before word `from`.
+ * @param target the rank of the first one on which the function must be called.
+ * @param f the function.
+ */
+template <bool ZERO = false, typename F> void scan_ones(const uint64_t *const bits, const uint64_t num_bits, const uint64_t from, const uint64_t to, uint64_t rank, uint64_t target, F &&f) {
+	for (uint64_t i = from; i < to; i++) {
+		const uint64_t word = scan_word<ZERO>(bits, num_bits, i);
+		const uint64_t end = rank + nu(word);
+		while (target < end) target = f(target, i * 64 + select64(word, target - rank));
+		rank = end;
+	}
+}
+
+/** Counts the ones in the slices of the words of a bit vector in parallel.
+ *
+ * @tparam ZERO whether to count the zeroes instead of the ones.
+ * @param bits a bit vector of 64-bit words.
+ * @param num_bits the length (in bits) of the bit vector.
+ * @param threads the number of threads, and of slices of the words of the bit vector.
+ * @return a vector of `threads` + 1 elements whose `t`-th element is the number of ones
+ * before the `t`-th slice; the last element is the number of ones in the bit vector.
+ */
+template <bool ZERO = false> std::vector<uint64_t> slice_ranks(const uint64_t *const bits, const uint64_t num_bits, const int threads) {
+	std::vector<uint64_t> ranks(threads + 1);
+	parallel_slices((num_bits + 63) / 64, threads, [&](const int t, const uint64_t from, const uint64_t to) {
+		uint64_t c = 0;
+		for (uint64_t i = from; i < to; i++) c += nu(scan_word<ZERO>(bits, num_bits, i));
+		ranks[t + 1] = c;
+	});
+	for (int t = 0; t < threads; t++) ranks[t + 1] += ranks[t];
+	return ranks;
+}
+
+} // namespace sux
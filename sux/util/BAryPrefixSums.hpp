@@ -0,0 +1,269 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SearchablePrefixSums.hpp"
+#include "Vector.hpp"
+
+namespace sux::util {
+
+/** Searchable prefix sums based on a tree of arity eight.
+ *
+ * Each node is made of eight 64-bit counters, that is, a cache line, containing the
+ * inclusive prefix sums of the totals of its (up to) eight children; the leaves contain the
+ * prefix sums of groups of eight elements. Levels are stored bottom-up in separate vectors.
+ *
+ * prefix() reads one counter per level, find() ranks the bound in one node per level
+ * (on AVX2 hosts, with two vector comparisons and a population count), and add()
+ * adds the increment to a suffix of one node per level (on AVX2 hosts, with two masked vector additions).
+ * Thus, all operations touch log<sub>8</sub>(size()) + 1 cache lines, rather than log<sub>2</sub>(size()) + 1,
+ * at the price of a larger space occupancy than a Fenwick tree (about 73 bits per element).
+ * Nodes are aligned to cache lines only with allocation types based on `mmap()`.
+ *
+ * This structure can be plugged in sux::bits::WordDynRankSel and
+ * sux::bits::StrideDynRankSel as a searchable prefix-sum structure.
+ *
+ * @tparam BOUND maximum representable value (at most the maximum value of a `uint64_t`).
+ * @tparam AT a type of memory allocation out of ::AllocType.
+ */
+
+template <size_t BOUND, AllocType AT = MALLOC> class BAryPrefixSums : public SearchablePrefixSums {
+  public:
+	static constexpr int LOG_ARITY = 3;
+	static constexpr size_t ARITY = 1 << LOG_ARITY;
+
+  protected:
+	static constexpr size_t MAX_LEVELS = 64 / LOG_ARITY + 1;
+	Vector<uint64_t, AT> Tree[MAX_LEVELS];
+	size_t Levels, Size;
+
+	// The levels needed so that the root covers [0..size], as prefix(size) reads the node containing index size.
+	static size_t levels(size_t size) { return size == 0 ? 1 : lambda(size) / LOG_ARITY + 1; }
+
+	static size_t nodes(size_t size, size_t level) {
+		const size_t shift = LOG_ARITY * (level + 1);
+		return shift < 64 ? (size >> shift) + 1 : 1;
+	}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	__attribute__((target("avx2"))) static int rank_node_avx2(const uint64_t *node, const uint64_t val) {
+		// Unsigned comparison through signed comparison with flipped sign bits
+		const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+		const __m256i v = _mm256_xor_si256(_mm256_set1_epi64x(val), sign);
+		const __m256i gt_lo = _mm256_cmpgt_epi64(_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)node), sign), v);
+		const __m256i gt_hi = _mm256_cmpgt_epi64(_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(node + 4)), sign), v);
+		return ARITY - nu(_mm256_movemask_pd(_mm256_castsi256_pd(gt_lo)) | _mm256_movemask_pd(_mm256_castsi256_pd(gt_hi)) << 4);
+	}
+
+	__attribute__((target("avx2"))) static void add_node_avx2(uint64_t *node, const int from, const int64_t inc) {
+		const __m256i v = _mm256_set1_epi64x(inc), f = _mm256_set1_epi64x(from - 1);
+		const __m256i lo = _mm256_and_si256(_mm256_cmpgt_epi64(_mm256_setr_epi64x(0, 1, 2, 3), f), v);
+		const __m256i hi = _mm256_and_si256(_mm256_cmpgt_epi64(_mm256_setr_epi64x(4, 5, 6, 7), f), v);
+		_mm256_storeu_si256((__m256i *)node, _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)node), lo));
+		_mm256_storeu_si256((__m256i *)(node + 4), _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(node + 4)), hi));
+	}
+#endif
+
+	// Returns the number of counters of a node smaller than or equal to val.
+	static int rank_node(const uint64_t *node, const uint64_t val) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#ifdef __AVX2__
+		const bool avx2 = true;
+#else
+		const bool avx2 = cpu_features.avx2;
+#endif
+		if (avx2) return rank_node_avx2(node, val);
+#endif
+		int r = 0;
+		for (size_t i = 0; i < ARITY; i++) r += node[i] <= val;
+		return r;
+	}
+
+	// Adds inc to the counters of a node from the given one onwards.
+	static void add_node(uint64_t *node, const int from, const int64_t inc) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#ifdef __AVX2__
+		const bool avx2 = true;
+#else
+		const bool avx2 = cpu_features.avx2;
+#endif
+		if (avx2) return add_node_avx2(node, from, inc);
+#endif
+		for (size_t i = from; i < ARITY; i++) node[i] += inc;
+	}
+
+  public:
+	/** Creates a new instance with no values (empty sequence). */
+	BAryPrefixSums() : Levels(1), Size(0) { Tree[0].size(ARITY); }
+
+	/** Creates a new instance with given vector of values.
+	 *
+	 * Note that the provided sequence is read at construction time but
+	 * it will not be referenced afterwards.
+	 *
+	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
+	 * @param size the number of elements in the sequence.
+	 */
+	BAryPrefixSums(uint64_t sequence[], size_t size) : Levels(levels(size)), Size(size) {
+		for (size_t l = 0; l < Levels; l++) {
+			const size_t n = nodes(size, l), children = l == 0 ? size : nodes(size, l - 1);
+			Tree[l].size(n * ARITY);
+			for (size_t node = 0; node < n; node++) {
+				uint64_t sum = 0;
+				for (size_t i = 0; i < ARITY; i++) {
+					const size_t child = node * ARITY + i;
+					if (child < children) sum += l == 0 ? sequence[child] : Tree[l - 1][child * ARITY + ARITY - 1];
+					Tree[l][child] = sum;
+				}
+			}
+		}
+	}
+
+	virtual uint64_t prefix(size_t length) {
+		uint64_t sum = 0;
+
+		// At each level, the counter preceding the one of the node containing length
+		for (size_t l = 0; l < Levels; l++, length >>= LOG_ARITY)
+			if (length % ARITY != 0) sum += Tree[l][length - 1];
+
+		return sum;
+	}
+
+	virtual void add(size_t idx, int64_t inc) {
+		for (size_t l = 0, i = idx - 1; l < Levels; l++, i >>= LOG_ARITY) add_node(&Tree[l] + (i & -ARITY), i % ARITY, inc);
+	}
+
+	using SearchablePrefixSums::find;
+	virtual size_t find(uint64_t *val) {
+		const uint64_t total = Tree[Levels - 1][ARITY - 1];
+		if (*val >= total) {
+			*val -= total;
+			return Size;
+		}
+
+		// From now on, the bound is smaller than the total of the current node, so we never reach empty children
+		size_t node = 0;
+		for (size_t l = Levels; l-- != 0;) {
+			const uint64_t *const counters = &Tree[l] + node * ARITY;
+			const int r = rank_node(counters, *val);
+			if (r != 0) *val -= counters[r - 1];
+			node = node * ARITY + r;
+		}
+
+		return node;
+	}
+
+	using SearchablePrefixSums::compFind;
+	virtual size_t compFind(uint64_t *val) {
+		const uint64_t total = Size * BOUND - Tree[Levels - 1][ARITY - 1];
+		if (*val >= total) {
+			*val -= total;
+			return Size;
+		}
+
+		size_t node = 0;
+		for (size_t l = Levels; l-- != 0;) {
+			const uint64_t *const counters = &Tree[l] + node * ARITY;
+			// Elements before the current node, and elements in the current node
+			const size_t base = node << (LOG_ARITY * l), left = Size - base;
+			uint64_t prev = 0;
+			int r = 0;
+			for (; r < int(ARITY); r++) {
+				const size_t elements = left >> (LOG_ARITY * l) > size_t(r) ? size_t(r + 1) << (LOG_ARITY * l) : left;
+				const uint64_t comp = elements * BOUND - counters[r];
+				if (comp > *val) break;
+				prev = comp;
+			}
+			*val -= prev;
+			node = node * ARITY + r;
+		}
+
+		return node;
+	}
+
+	virtual void push(uint64_t val) {
+		++Size;
+		if (Levels < MAX_LEVELS && Size >> (LOG_ARITY * Levels) != 0) {
+			// A new root, whose first child is the old (full) root
+			Tree[Levels].resize(ARITY);
+			const uint64_t total = Tree[Levels - 1][ARITY - 1];
+			for (size_t i = 0; i < ARITY; i++) Tree[Levels][i] = total;
+			Levels++;
+		}
+
+		// New nodes are needed only at levels at which the size is a multiple of the node coverage
+		for (size_t l = 0; l < Levels; l++) {
+			const size_t length = nodes(Size, l) * ARITY;
+			if (Tree[l].size() == length) break;
+			Tree[l].resize(length);
+			for (size_t i = length - ARITY; i < length; i++) Tree[l][i] = 0;
+		}
+
+		add(Size, val);
+	}
+
+	virtual void pop() {
+		const size_t i = Size - 1;
+		add(Size, -(Tree[0][i] - (i % ARITY != 0 ? Tree[0][i - 1] : 0)));
+
+		--Size;
+		for (size_t l = 0; l < Levels; l++) {
+			const size_t length = nodes(Size, l) * ARITY;
+			if (Tree[l].size() == length) break;
+			Tree[l].resize(length);
+		}
+
+		if (Levels > 1 && Size >> (LOG_ARITY * (Levels - 1)) == 0) Tree[--Levels].resize(0);
+	}
+
+	virtual size_t size() const { return Size; }
+
+	virtual size_t bitCount() const {
+		size_t ret = sizeof(*this) * 8;
+		for (size_t i = 0; i < MAX_LEVELS; i++) ret += Tree[i].bitCount() - sizeof(Tree[i]) * 8;
+		return ret;
+	}
+
+  private:
+	friend std::ostream &operator<<(std::ostream &os, const BAryPrefixSums<BOUND, AT> &ps) {
+		os.write((char *)&ps.Size, sizeof(uint64_t));
+		os.write((char *)&ps.Levels, sizeof(uint64_t));
+		for (size_t i = 0; i < ps.Levels; i++) os << ps.Tree[i];
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, BAryPrefixSums<BOUND, AT> &ps) {
+		is.read((char *)&ps.Size, sizeof(uint64_t));
+		is.read((char *)&ps.Levels, sizeof(uint64_t));
+		for (size_t i = 0; i < ps.Levels; i++) is >> ps.Tree[i];
+		return is;
+	}
+};
+
+} // namespace sux::util
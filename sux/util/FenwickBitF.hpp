@@ -61,14 +61,10 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitF : public Search
 	 *
 	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
 	 * @param size the number of elements in the sequence.
+	 * @param threads the number of threads used for construction.
 	 */
 
-	FenwickBitF(uint64_t sequence[], size_t size) : Tree((first_bit_after(size) + END_PADDING + 7) >> 3), Size(size) {
-		for (size_t idx = 1; idx <= Size; idx++) addToPartialFrequency(idx, sequence[idx - 1]);
-
-		for (size_t m = 2; m <= Size; m <<= 1)
-			for (size_t idx = m; idx <= Size; idx += m) addToPartialFrequency(idx, getPartialFrequency(idx - m / 2));
-	}
+	FenwickBitF(uint64_t sequence[], size_t size, int threads = 1) : Tree((first_bit_after(size) + END_PADDING + 7) >> 3), Size(size) { build(sequence, 0, Size, threads); }
 
 	virtual uint64_t prefix(size_t idx) {
 		uint64_t sum = 0;
@@ -125,15 +121,68 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitF : public Search
 		return node;
 	}
 
+	virtual void addBatch(const size_t idx[], const int64_t inc[], size_t n) {
+		fenwickAddBatch(idx, inc, n, Size, [this](size_t node, int64_t c) { addToPartialFrequency(node, c); });
+	}
+
+	virtual void prefixBatch(const size_t length[], uint64_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			if (i + BATCH_GROUP < n)
+				for (size_t idx = length[i + BATCH_GROUP]; idx != 0; idx = clear_rho(idx)) prefetchPartialFrequency(idx);
+			out[i] = FenwickBitF::prefix(length[i]);
+		}
+	}
+
+	virtual void findBatch(uint64_t val[], size_t out[], size_t n) {
+		for (size_t g = 0; g < n; g += BATCH_GROUP) {
+			const size_t k = min(BATCH_GROUP, n - g);
+
+			// Local state, so that the compiler can keep it apart from the tree
+			uint64_t v[BATCH_GROUP];
+			size_t node[BATCH_GROUP];
+			for (size_t j = 0; j < k; j++) {
+				v[j] = val[g + j];
+				node[j] = 0;
+			}
+
+			// One step of each search in turn, prefetching the node probed by the next step
+			for (size_t m = mask_lambda(Size); m != 0; m >>= 1) {
+				for (size_t j = 0; j < k; j++) {
+					if (node[j] + m <= Size) {
+						const uint64_t value = getPartialFrequency(node[j] + m);
+
+						// Branchless, as the outcome is unpredictable
+						const bool right = v[j] >= value;
+						node[j] += right ? m : 0;
+						v[j] -= right ? value : 0;
+					}
+
+					if (m != 1 && node[j] + m / 2 <= Size) prefetchPartialFrequency(node[j] + m / 2);
+				}
+			}
+
+			for (size_t j = 0; j < k; j++) {
+				val[g + j] = v[j];
+				out[g + j] = node[j];
+			}
+		}
+	}
+
 	virtual void push(uint64_t val) {
 		Tree.resize((first_bit_after(++Size) + END_PADDING + 7) >> 3);
-		addToPartialFrequency(Size, val);
+		setPartialFrequency(Size, val);
 
 		if ((Size & 1) == 0) {
-			for (size_t idx = Size - 1; rho(idx) < rho(Size); idx = clear_rho(idx)) addToPartialFrequency(Size, getPartialFrequency(idx));
+			for (size_t idx = Size - 1; idx != 0 && rho(idx) < rho(Size); idx = clear_rho(idx)) addToPartialFrequency(Size, getPartialFrequency(idx));
 		}
 	}
 
+	virtual void append(const uint64_t seq[], size_t n) {
+		Tree.resize((first_bit_after(Size + n) + END_PADDING + 7) >> 3);
+		build(seq, Size, Size + n, 1);
+		Size += n;
+	}
+
 	virtual void pop() { Tree.resize((first_bit_after(--Size) + END_PADDING + 7) >> 3); }
 
 	virtual void grow(size_t space) { Tree.grow((first_bit_after(space) + END_PADDING + 7) >> 3); }
@@ -173,6 +222,31 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitF : public Search
 		}
 	}
 
+	inline void setPartialFrequency(size_t idx, uint64_t value) {
+		const uint64_t mask = (UINT64_C(1) << (BOUNDSIZE + rho(idx))) - 1;
+		idx--;
+		const uint64_t prod = (BOUNDSIZE + 1) * idx;
+		const uint64_t pos = prod - nu(idx) + holes(idx);
+
+		uint64_t t;
+		if ((prod + (BOUNDSIZE + 1)) % 64 == 0) {
+			uint64_t *const p = (uint64_t *)&Tree[0] + pos / 64;
+			memcpy(&t, p, 8);
+			t = (t & ~(mask << (pos % 64))) | value << (pos % 64);
+			memcpy(p, &t, 8);
+		} else {
+			uint8_t *const p = &Tree[0] + pos / 8;
+			memcpy(&t, p, 8);
+			t = (t & ~(mask << (pos % 8))) | value << (pos % 8);
+			memcpy(p, &t, 8);
+		}
+	}
+
+	inline void prefetchPartialFrequency(size_t idx) const {
+		idx--;
+		__builtin_prefetch(&Tree[0] + ((BOUNDSIZE + 1) * idx - nu(idx) + holes(idx)) / 8);
+	}
+
 	inline void addToPartialFrequency(size_t idx, uint64_t value) {
 		idx--;
 		const uint64_t prod = (BOUNDSIZE + 1) * idx;
@@ -192,6 +266,10 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitF : public Search
 		}
 	}
 
+	void build(const uint64_t seq[], size_t from, size_t to, int threads) {
+		fenwickBuild(seq, from, to, threads, [this](size_t j) { return getPartialFrequency(j); }, [this](size_t j, uint64_t value) { setPartialFrequency(j, value); });
+	}
+
 	friend std::ostream &operator<<(std::ostream &os, const FenwickBitF<BOUND, AT> &ft) {
 		os.write((char *)&ft.Size, sizeof(uint64_t));
 		return os << ft.Tree;
@@ -59,25 +59,11 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 	 *
 	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
 	 * @param size the number of elements in the sequence.
+	 * @param threads the number of threads used for construction.
 	 */
-	FenwickBitL(uint64_t sequence[], size_t size) : Levels(size != 0 ? lambda(size) + 1 : 1), Size(size) {
+	FenwickBitL(uint64_t sequence[], size_t size, int threads = 1) : Levels(size != 0 ? lambda(size) + 1 : 1), Size(size) {
 		this->size(size ? size : 1);
-
-		for (size_t l = 0; l < Levels; l++) {
-			for (size_t node = 1ULL << l; node <= size; node += 1ULL << (l + 1)) {
-				size_t sequence_idx = node - 1;
-				uint64_t value = sequence[sequence_idx];
-
-				for (size_t j = 0; j < l; j++) {
-					sequence_idx >>= 1;
-					const size_t lowpos = (BOUNDSIZE + j) * sequence_idx;
-					value += bitread(&Tree[j][lowpos / 8], lowpos % 8, BOUNDSIZE + j);
-				}
-
-				const size_t highpos = (BOUNDSIZE + l) * (node >> (l + 1));
-				bitwrite_inc(&Tree[l][highpos / 8], highpos % 8, BOUNDSIZE + l, value);
-			}
-		}
+		build(sequence, 0, size, threads);
 	}
 
 	virtual uint64_t prefix(size_t idx) {
@@ -113,7 +99,7 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 
 			idx <<= 1;
 
-			if ((pos + BOUNDSIZE + height) / 8 + 7 >= Tree[height].size()) continue;
+			if (node + (1ULL << height) > Size) continue;
 
 			const uint64_t value = bitread(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height);
 
@@ -136,7 +122,7 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 
 			idx <<= 1;
 
-			if ((pos + BOUNDSIZE + height) / 8 + 7 >= Tree[height].size()) continue;
+			if (node + (1ULL << height) > Size) continue;
 
 			const uint64_t value = (BOUND << height) - bitread(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height);
 
@@ -150,6 +136,68 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 		return min(node, Size);
 	}
 
+	virtual void addBatch(const size_t idx[], const int64_t inc[], size_t n) {
+		fenwickAddBatch(idx, inc, n, Size, [this](size_t node, int64_t c) {
+			const int height = rho(node);
+			const size_t pos = (node >> (1 + height)) * (BOUNDSIZE + height);
+			bitwrite_inc(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height, c);
+		});
+	}
+
+	virtual void prefixBatch(const size_t length[], uint64_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			if (i + BATCH_GROUP < n)
+				for (size_t idx = length[i + BATCH_GROUP]; idx != 0; idx = clear_rho(idx)) {
+					const int height = rho(idx);
+					__builtin_prefetch(&Tree[height][(idx >> (1 + height)) * (BOUNDSIZE + height) / 8]);
+				}
+			out[i] = FenwickBitL::prefix(length[i]);
+		}
+	}
+
+	virtual void findBatch(uint64_t val[], size_t out[], size_t n) {
+		for (size_t g = 0; g < n; g += BATCH_GROUP) {
+			const size_t k = min(BATCH_GROUP, n - g);
+
+			// Local state, so that the compiler can keep it apart from the tree
+			uint64_t v[BATCH_GROUP];
+			size_t node[BATCH_GROUP], idx[BATCH_GROUP];
+			for (size_t j = 0; j < k; j++) {
+				v[j] = val[g + j];
+				node[j] = idx[j] = 0;
+			}
+
+			// One step of each search in turn, prefetching the node probed by the next step
+			for (size_t height = Levels - 1; height != SIZE_MAX; height--) {
+				for (size_t j = 0; j < k; j++) {
+					const size_t pos = idx[j] * (BOUNDSIZE + height);
+
+					idx[j] <<= 1;
+
+					if (node[j] + (1ULL << height) <= Size) {
+						const uint64_t value = bitread(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height);
+
+						// Branchless, as the outcome is unpredictable
+						const bool right = v[j] >= value;
+						idx[j] += right;
+						v[j] -= right ? value : 0;
+						node[j] += size_t(right) << height;
+					}
+
+					if (height != 0) {
+						const size_t next = idx[j] * (BOUNDSIZE + height - 1);
+						if ((next + BOUNDSIZE + height - 1) / 8 + 7 < Tree[height - 1].size()) __builtin_prefetch(&Tree[height - 1][next / 8]);
+					}
+				}
+			}
+
+			for (size_t j = 0; j < k; j++) {
+				val[g + j] = v[j];
+				out[g + j] = min(node[j], Size);
+			}
+		}
+	}
+
 	virtual void push(uint64_t val) {
 		Levels = lambda(++Size) + 1;
 
@@ -157,8 +205,8 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 		size_t idx = Size >> (1 + height);
 		size_t hipos = (BOUNDSIZE + height) * idx;
 
-		Tree[height].resize(hipos / 8 + 8);
-		bitwrite_inc(&Tree[height][hipos / 8], hipos % 8, BOUNDSIZE + height, val);
+		Tree[height].resize((hipos + BOUNDSIZE + height) / 8 + 8);
+		bitwrite(&Tree[height][hipos / 8], hipos % 8, BOUNDSIZE + height, val);
 
 		idx <<= 1;
 		for (size_t h = height - 1; h != SIZE_MAX; h--) {
@@ -170,10 +218,18 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 		}
 	}
 
+	virtual void append(const uint64_t seq[], size_t n) {
+		if (n == 0) return;
+		resize(Size + n);
+		build(seq, Size, Size + n, 1);
+		Size += n;
+		Levels = lambda(Size) + 1;
+	}
+
 	virtual void pop() {
 		int height = rho(Size);
 		size_t pos = (BOUNDSIZE + height) * (Size >> (1 + height));
-		Tree[height].resize(pos / 8);
+		Tree[height].resize(pos / 8 + 8);
 		Size--;
 	}
 
@@ -212,6 +268,21 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickBitL : public Search
 	}
 
   private:
+	void build(const uint64_t seq[], size_t from, size_t to, int threads) {
+		fenwickBuild(
+			seq, from, to, threads,
+			[this](size_t j) {
+				const int height = rho(j);
+				const size_t pos = (BOUNDSIZE + height) * (j >> (1 + height));
+				return bitread(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height);
+			},
+			[this](size_t j, uint64_t value) {
+				const int height = rho(j);
+				const size_t pos = (BOUNDSIZE + height) * (j >> (1 + height));
+				bitwrite(&Tree[height][pos / 8], pos % 8, BOUNDSIZE + height, value);
+			});
+	}
+
 	friend std::ostream &operator<<(std::ostream &os, const FenwickBitL<BOUND, AT> &ft) {
 		os.write((char *)&ft.Size, sizeof(uint64_t));
 		os.write((char *)&ft.Levels, sizeof(uint64_t));
@@ -59,25 +59,11 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickByteL : public Searc
 	 *
 	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
 	 * @param size the number of elements in the sequence.
+	 * @param threads the number of threads used for construction.
 	 */
-	FenwickByteL(uint64_t sequence[], size_t size) : Levels(size != 0 ? lambda(size) + 1 : 1), Size(size) {
+	FenwickByteL(uint64_t sequence[], size_t size, int threads = 1) : Levels(size != 0 ? lambda(size) + 1 : 1), Size(size) {
 		this->size(size ? size : 1);
-
-		for (size_t l = 0; l < Levels; l++) {
-			for (size_t node = 1ULL << l; node <= Size; node += 1ULL << (l + 1)) {
-				size_t sequence_idx = node - 1;
-				uint64_t value = sequence[sequence_idx];
-
-				for (size_t j = 0; j < l; j++) {
-					sequence_idx >>= 1;
-					size_t lowpos = heightsize(j) * sequence_idx;
-					value += byteread(&Tree[j][lowpos], heightsize(j));
-				}
-
-				size_t highpos = heightsize(l) * (node >> (l + 1));
-				bytewrite(&Tree[l][highpos], heightsize(l), value);
-			}
-		}
+		build(sequence, 0, size, threads);
 	}
 
 	virtual uint64_t prefix(size_t idx) {
@@ -154,6 +140,67 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickByteL : public Searc
 		return min(node, Size);
 	}
 
+	virtual void addBatch(const size_t idx[], const int64_t inc[], size_t n) {
+		fenwickAddBatch(idx, inc, n, Size, [this](size_t node, int64_t c) {
+			const int height = rho(node);
+			bytewrite_inc(&Tree[height][(node >> (1 + height)) * heightsize(height)], c);
+		});
+	}
+
+	virtual void prefixBatch(const size_t length[], uint64_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			if (i + BATCH_GROUP < n)
+				for (size_t idx = length[i + BATCH_GROUP]; idx != 0; idx = clear_rho(idx)) {
+					const int height = rho(idx);
+					__builtin_prefetch(&Tree[height][(idx >> (1 + height)) * heightsize(height)]);
+				}
+			out[i] = FenwickByteL::prefix(length[i]);
+		}
+	}
+
+	virtual void findBatch(uint64_t val[], size_t out[], size_t n) {
+		for (size_t g = 0; g < n; g += BATCH_GROUP) {
+			const size_t k = min(BATCH_GROUP, n - g);
+
+			// Local state, so that the compiler can keep it apart from the tree
+			uint64_t v[BATCH_GROUP];
+			size_t node[BATCH_GROUP], idx[BATCH_GROUP];
+			for (size_t j = 0; j < k; j++) {
+				v[j] = val[g + j];
+				node[j] = idx[j] = 0;
+			}
+
+			// One step of each search in turn, prefetching the node probed by the next step
+			for (size_t height = Levels - 1; height != SIZE_MAX; height--) {
+				for (size_t j = 0; j < k; j++) {
+					const size_t pos = idx[j] * heightsize(height);
+
+					idx[j] <<= 1;
+
+					if (pos < Tree[height].size() - 8) {
+						const uint64_t value = byteread(&Tree[height][pos], heightsize(height));
+
+						// Branchless, as the outcome is unpredictable
+						const bool right = v[j] >= value;
+						idx[j] += right;
+						v[j] -= right ? value : 0;
+						node[j] += size_t(right) << height;
+					}
+
+					if (height != 0) {
+						const size_t next = idx[j] * heightsize(height - 1);
+						if (next < Tree[height - 1].size() - 8) __builtin_prefetch(&Tree[height - 1][next]);
+					}
+				}
+			}
+
+			for (size_t j = 0; j < k; j++) {
+				val[g + j] = v[j];
+				out[g + j] = min(node[j], Size);
+			}
+		}
+	}
+
 	virtual void push(uint64_t val) {
 		Levels = lambda(++Size) + 1;
 
@@ -162,7 +209,7 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickByteL : public Searc
 		size_t hisize = heightsize(height);
 		size_t highpos = idx * hisize;
 
-		Tree[height].resize(highpos + 8);
+		Tree[height].resize(highpos + hisize + 8);
 		bytewrite(&Tree[height][highpos], hisize, val);
 
 		idx <<= 1;
@@ -178,9 +225,17 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickByteL : public Searc
 		}
 	}
 
+	virtual void append(const uint64_t seq[], size_t n) {
+		if (n == 0) return;
+		resize(Size + n);
+		build(seq, Size, Size + n, 1);
+		Size += n;
+		Levels = lambda(Size) + 1;
+	}
+
 	virtual void pop() {
 		int height = rho(Size);
-		Tree[height].resize((Size >> (1 + height)) * heightsize(height) + 7);
+		Tree[height].resize((Size >> (1 + height)) * heightsize(height) + 8);
 		Size--;
 	}
 
@@ -221,6 +276,19 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickByteL : public Searc
   private:
 	static inline size_t heightsize(size_t height) { return ((height + BOUNDSIZE - 1) >> 3) + 1; }
 
+	void build(const uint64_t seq[], size_t from, size_t to, int threads) {
+		fenwickBuild(
+			seq, from, to, threads,
+			[this](size_t j) {
+				const int height = rho(j);
+				return byteread(&Tree[height][heightsize(height) * (j >> (1 + height))], heightsize(height));
+			},
+			[this](size_t j, uint64_t value) {
+				const int height = rho(j);
+				bytewrite(&Tree[height][heightsize(height) * (j >> (1 + height))], heightsize(height), value);
+			});
+	}
+
 	friend std::ostream &operator<<(std::ostream &os, const FenwickByteL<BOUND, AT> &ft) {
 		os.write((char *)&ft.Size, sizeof(uint64_t));
 		os.write((char *)&ft.Levels, sizeof(uint64_t));
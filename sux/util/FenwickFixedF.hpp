@@ -59,14 +59,9 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickFixedF : public Sear
 	 *
 	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
 	 * @param size the number of elements in the sequence.
+	 * @param threads the number of threads used for construction.
 	 */
-	FenwickFixedF(uint64_t sequence[], size_t size) : Tree(pos(size) + 1), Size(size) {
-		for (size_t j = 1; j <= Size; j++) Tree[pos(j)] = sequence[j - 1];
-
-		for (size_t m = 2; m <= Size; m <<= 1) {
-			for (size_t idx = m; idx <= Size; idx += m) Tree[pos(idx)] += Tree[pos(idx - m / 2)];
-		}
-	}
+	FenwickFixedF(uint64_t sequence[], size_t size, int threads = 1) : Tree(pos(size) + 1), Size(size) { build(sequence, 0, Size, threads); }
 
 	virtual uint64_t prefix(size_t idx) {
 		uint64_t sum = 0;
@@ -122,16 +117,69 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickFixedF : public Sear
 		return node;
 	}
 
+	virtual void addBatch(const size_t idx[], const int64_t inc[], size_t n) {
+		fenwickAddBatch(idx, inc, n, Size, [this](size_t node, int64_t c) { Tree[pos(node)] += c; });
+	}
+
+	virtual void prefixBatch(const size_t length[], uint64_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			if (i + BATCH_GROUP < n)
+				for (size_t idx = length[i + BATCH_GROUP]; idx != 0; idx = clear_rho(idx)) __builtin_prefetch(&Tree[pos(idx)]);
+			out[i] = FenwickFixedF::prefix(length[i]);
+		}
+	}
+
+	virtual void findBatch(uint64_t val[], size_t out[], size_t n) {
+		for (size_t g = 0; g < n; g += BATCH_GROUP) {
+			const size_t k = min(BATCH_GROUP, n - g);
+
+			// Local state, so that the compiler can keep it apart from the tree
+			uint64_t v[BATCH_GROUP];
+			size_t node[BATCH_GROUP];
+			for (size_t j = 0; j < k; j++) {
+				v[j] = val[g + j];
+				node[j] = 0;
+			}
+
+			// One step of each search in turn, prefetching the node probed by the next step
+			for (size_t m = mask_lambda(Size); m != 0; m >>= 1) {
+				for (size_t j = 0; j < k; j++) {
+					if (node[j] + m <= Size) {
+						const uint64_t value = Tree[pos(node[j] + m)];
+
+						// Branchless, as the outcome is unpredictable
+						const bool right = v[j] >= value;
+						node[j] += right ? m : 0;
+						v[j] -= right ? value : 0;
+					}
+
+					if (m != 1 && node[j] + m / 2 <= Size) __builtin_prefetch(&Tree[pos(node[j] + m / 2)]);
+				}
+			}
+
+			for (size_t j = 0; j < k; j++) {
+				val[g + j] = v[j];
+				out[g + j] = node[j];
+			}
+		}
+	}
+
 	virtual void push(uint64_t val) {
 		size_t p = pos(++Size);
 		Tree.resize(p + 1);
 		Tree[p] = val;
 
 		if ((Size & 1) == 0) {
-			for (size_t idx = Size - 1; rho(idx) < rho(Size); idx = clear_rho(idx)) Tree[p] += Tree[pos(idx)];
+			for (size_t idx = Size - 1; idx != 0 && rho(idx) < rho(Size); idx = clear_rho(idx)) Tree[p] += Tree[pos(idx)];
 		}
 	}
 
+	virtual void append(const uint64_t seq[], size_t n) {
+		Tree.resize(pos(Size + n) + 1);
+		build(seq, Size, Size + n, 1);
+		Size += n;
+	}
+
 	virtual void pop() {
 		Size--;
 		Tree.popBack();
@@ -157,6 +205,10 @@ template <size_t BOUND, AllocType AT = MALLOC> class FenwickFixedF : public Sear
 
 	static inline size_t pos(size_t idx) { return idx + holes(idx); }
 
+	void build(const uint64_t seq[], size_t from, size_t to, int threads) {
+		fenwickBuild(seq, from, to, threads, [this](size_t j) { return Tree[pos(j)]; }, [this](size_t j, uint64_t value) { Tree[pos(j)] = value; });
+	}
+
 	friend std::ostream &operator<<(std::ostream &os, const FenwickFixedF<BOUND, AT> &ft) {
 		os.write((char *)&ft.Size, sizeof(uint64_t));
 		return os << ft.Tree;
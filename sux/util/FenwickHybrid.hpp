@@ -0,0 +1,302 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SearchablePrefixSums.hpp"
+#include "Vector.hpp"
+
+namespace sux::util {
+
+/** A hybrid Fenwick tree in level-order layout: bit-compressed lower levels and word-aligned upper levels.
+ *
+ * Nodes of height smaller than `SPLIT` are stored as in FenwickBitL, using the minimum number
+ * of bits; nodes of height `SPLIT` or more are stored as in FenwickFixedL, in a full word.
+ * Lower levels contain most nodes, so they determine the space used and the cache density
+ * of the structure; upper levels contain few nodes, which are accessed with aligned reads and writes.
+ *
+ * Searchable prefix-sum template arguments (e.g., of sux::bits::WordDynRankSel) must have
+ * two parameters: use FenwickHybridSplit<SPLIT>::type.
+ *
+ * @tparam BOUND maximum representable value (at most the maximum value of a `uint64_t`).
+ * @tparam SPLIT the height of the lowest word-aligned level (between 1 and 64).
+ * @tparam AT a type of memory allocation out of ::AllocType.
+ */
+
+template <size_t BOUND, size_t SPLIT, AllocType AT = MALLOC> class FenwickHybrid : public SearchablePrefixSums, public Expandable {
+  public:
+	static constexpr size_t BOUNDSIZE = ceil_log2_plus1(BOUND);
+	static_assert(BOUNDSIZE >= 1 && BOUNDSIZE <= 64, "Leaves can't be stored in a 64-bit word");
+	static_assert(SPLIT >= 1 && SPLIT <= 64, "The split height must be between 1 and 64");
+
+  protected:
+	Vector<uint8_t, AT> Bottom[SPLIT];
+	Vector<uint64_t, AT> Top[64];
+	size_t Levels, Size;
+
+  public:
+	/** Creates a new instance with no values (empty tree). */
+	FenwickHybrid() : Levels(0), Size(0) {}
+
+	/** Creates a new instance with given vector of values.
+	 *
+	 * Note that the provided sequence is read at construction time but
+	 * it will not be referenced afterwards.
+	 *
+	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
+	 * @param size the number of elements in the sequence.
+	 */
+	FenwickHybrid(uint64_t sequence[], size_t size) : Levels(size != 0 ? lambda(size) + 1 : 1), Size(size) {
+		this->size(size ? size : 1);
+
+		for (size_t l = 0; l < Levels; l++) {
+			for (size_t node = 1ULL << l; node <= size; node += 1ULL << (l + 1)) {
+				size_t sequence_idx = node - 1;
+				uint64_t value = sequence[sequence_idx];
+				for (size_t j = 0; j < l; j++) {
+					sequence_idx >>= 1;
+					value += get(j, sequence_idx);
+				}
+
+				set(l, node >> (l + 1), value);
+			}
+		}
+	}
+
+	virtual uint64_t prefix(size_t idx) {
+		uint64_t sum = 0;
+
+		while (idx != 0) {
+			const int height = rho(idx);
+			sum += get(height, idx >> (1 + height));
+
+			idx = clear_rho(idx);
+		}
+
+		return sum;
+	}
+
+	virtual void add(size_t idx, int64_t inc) {
+		while (idx <= Size) {
+			const int height = rho(idx);
+			const size_t level_idx = idx >> (1 + height);
+			if (height < int(SPLIT)) {
+				const size_t pos = level_idx * (BOUNDSIZE + height);
+				bitwrite_inc(&Bottom[height][pos / 8], pos % 8, BOUNDSIZE + height, inc);
+			} else
+				Top[height][level_idx] += inc;
+
+			idx += mask_rho(idx);
+		}
+	}
+
+	using SearchablePrefixSums::find;
+	virtual size_t find(uint64_t *val) {
+		size_t node = 0, idx = 0;
+
+		for (size_t height = Levels - 1; height != SIZE_MAX; height--) {
+			const size_t pos = idx;
+
+			idx <<= 1;
+
+			if (node + (1ULL << height) > Size) continue;
+
+			const uint64_t value = get(height, pos);
+			if (*val >= value) {
+				idx++;
+				*val -= value;
+				node += 1ULL << height;
+			}
+		}
+
+		return node;
+	}
+
+	using SearchablePrefixSums::compFind;
+	virtual size_t compFind(uint64_t *val) {
+		size_t node = 0, idx = 0;
+
+		for (size_t height = Levels - 1; height != SIZE_MAX; height--) {
+			const size_t pos = idx;
+
+			idx <<= 1;
+
+			if (node + (1ULL << height) > Size) continue;
+
+			const uint64_t value = (BOUND << height) - get(height, pos);
+			if (*val >= value) {
+				idx++;
+				*val -= value;
+				node += 1ULL << height;
+			}
+		}
+
+		return node;
+	}
+
+	virtual void push(uint64_t val) {
+		Levels = lambda(++Size) + 1;
+
+		const int height = rho(Size);
+		const size_t level_idx = Size >> (1 + height);
+		if (height < int(SPLIT))
+			Bottom[height].resize(bytes(level_idx + 1, height));
+		else
+			Top[height].resize(level_idx + 1);
+
+		size_t idx = level_idx << 1;
+		for (int h = height - 1; h >= 0; h--) {
+			val += get(h, idx);
+			idx = (idx << 1) + 1;
+		}
+
+		// Popped nodes might have left stale bits, so we overwrite the node
+		set(height, level_idx, val);
+	}
+
+	virtual void pop() {
+		const int height = rho(Size);
+		const size_t level_idx = Size-- >> (1 + height);
+		if (height < int(SPLIT))
+			Bottom[height].resize(bytes(level_idx, height));
+		else
+			Top[height].popBack();
+	}
+
+	virtual void grow(size_t space) {
+		const size_t levels = lambda(space) + 1;
+		for (size_t i = 0; i < levels; i++)
+			if (i < SPLIT)
+				Bottom[i].grow(bytes(nodes(space, i), i));
+			else
+				Top[i].grow(nodes(space, i));
+	}
+
+	virtual void reserve(size_t space) {
+		const size_t levels = lambda(space) + 1;
+		for (size_t i = 0; i < levels; i++)
+			if (i < SPLIT)
+				Bottom[i].reserve(bytes(nodes(space, i), i));
+			else
+				Top[i].reserve(nodes(space, i));
+	}
+
+	using Expandable::trimToFit;
+	virtual void trim(size_t space) {
+		const size_t levels = lambda(space) + 1;
+		for (size_t i = 0; i < levels; i++)
+			if (i < SPLIT)
+				Bottom[i].trim(bytes(nodes(space, i), i));
+			else
+				Top[i].trim(nodes(space, i));
+	}
+
+	virtual void resize(size_t space) {
+		const size_t levels = lambda(space) + 1;
+		for (size_t i = 0; i < levels; i++)
+			if (i < SPLIT)
+				Bottom[i].resize(bytes(nodes(space, i), i));
+			else
+				Top[i].resize(nodes(space, i));
+	}
+
+	virtual void size(size_t space) {
+		const size_t levels = lambda(space) + 1;
+		for (size_t i = 0; i < levels; i++)
+			if (i < SPLIT)
+				Bottom[i].size(bytes(nodes(space, i), i));
+			else
+				Top[i].size(nodes(space, i));
+	}
+
+	virtual size_t size() const { return Size; }
+
+	virtual size_t bitCount() const {
+		size_t ret = sizeof(*this) * 8;
+		for (size_t i = 0; i < SPLIT; i++) ret += Bottom[i].bitCount() - sizeof(Bottom[i]) * 8;
+		for (size_t i = 0; i < 64; i++) ret += Top[i].bitCount() - sizeof(Top[i]) * 8;
+		return ret;
+	}
+
+  private:
+	// The number of nodes of given height in a tree of given size
+	static size_t nodes(size_t size, size_t height) { return (size + (1ULL << height)) >> (height + 1); }
+
+	// The number of bytes necessary to store a given number of nodes of given height in a bit-compressed level
+	static size_t bytes(size_t nodes, size_t height) { return nodes * (BOUNDSIZE + height) / 8 + 8; }
+
+	uint64_t get(size_t height, size_t level_idx) const {
+		if (height < SPLIT) {
+			const size_t pos = level_idx * (BOUNDSIZE + height);
+			return bitread(&Bottom[height][pos / 8], pos % 8, BOUNDSIZE + height);
+		}
+		return Top[height][level_idx];
+	}
+
+	void set(size_t height, size_t level_idx, uint64_t value) {
+		if (height < SPLIT) {
+			const size_t pos = level_idx * (BOUNDSIZE + height);
+			bitwrite(&Bottom[height][pos / 8], pos % 8, BOUNDSIZE + height, value);
+		} else
+			Top[height][level_idx] = value;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const FenwickHybrid<BOUND, SPLIT, AT> &ft) {
+		os.write((char *)&ft.Size, sizeof(uint64_t));
+		os.write((char *)&ft.Levels, sizeof(uint64_t));
+		for (size_t i = 0; i < ft.Levels; i++)
+			if (i < SPLIT)
+				os << ft.Bottom[i];
+			else
+				os << ft.Top[i];
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, FenwickHybrid<BOUND, SPLIT, AT> &ft) {
+		is.read((char *)&ft.Size, sizeof(uint64_t));
+		is.read((char *)&ft.Levels, sizeof(uint64_t));
+		for (size_t i = 0; i < ft.Levels; i++)
+			if (i < SPLIT)
+				is >> ft.Bottom[i];
+			else
+				is >> ft.Top[i];
+		return is;
+	}
+};
+
+/** Binds the split height of FenwickHybrid, so that it can be used as a searchable prefix-sum template argument.
+ *
+ * For example, `sux::bits::WordDynRankSel<FenwickHybridSplit<8>::type>`.
+ *
+ * @tparam SPLIT the height of the lowest word-aligned level.
+ */
+template <size_t SPLIT> struct FenwickHybridSplit {
+	template <size_t BOUND, AllocType AT = MALLOC> using type = FenwickHybrid<BOUND, SPLIT, AT>;
+};
+
+} // namespace sux::util
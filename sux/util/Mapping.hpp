@@ -0,0 +1,167 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "Vector.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace sux::util {
+
+/** A read-only memory mapping of a file containing serialized structures.
+ *
+ * The static rank/select structures serialize themselves using only 64-bit
+ * fields, so their serialized form can be used in place: constructing such a
+ * structure from a mapping creates a read-only view whose arrays point
+ * directly into the mapping, which is read sequentially, one structure
+ * after the other, in the order in which they were serialized.
+ * No data is copied, and pages are loaded lazily by the operating system.
+ *
+ * The mapping must outlive the views created from it.
+ */
+
+class Mapping {
+	void *mem = nullptr;
+	size_t length = 0;
+	const uint64_t *cursor = nullptr;
+
+  public:
+	Mapping() = default;
+
+	/** Maps a file.
+	 *
+	 * @param path the name of a file containing serialized structures.
+	 */
+	explicit Mapping(const char *const path) {
+		const int fd = open(path, O_RDONLY);
+		struct stat st;
+		if (fd == -1 || fstat(fd, &st) == -1) {
+			fprintf(stderr, "Cannot open %s\n", path);
+			abort();
+		}
+
+		length = st.st_size;
+		if (length != 0) {
+			mem = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mem == MAP_FAILED) {
+				fprintf(stderr, "Cannot map %s\n", path);
+				abort();
+			}
+		}
+		close(fd);
+		cursor = static_cast<const uint64_t *>(mem);
+	}
+
+	~Mapping() {
+		if (mem != nullptr) {
+			int result = munmap(mem, length);
+			assert(result == 0 && "munmap failed");
+		}
+	}
+
+	Mapping(const Mapping &) = delete;
+	Mapping &operator=(const Mapping &) = delete;
+
+	Mapping(Mapping &&oth) : mem(std::exchange(oth.mem, nullptr)), length(std::exchange(oth.length, 0)), cursor(std::exchange(oth.cursor, nullptr)) {}
+
+	Mapping &operator=(Mapping &&oth) {
+		std::swap(mem, oth.mem);
+		std::swap(length, oth.length);
+		std::swap(cursor, oth.cursor);
+		return *this;
+	}
+
+	/** Returns a pointer to the given number of words at the current position, and skips them.
+	 *
+	 * @param words a number of 64-bit words.
+	 */
+	const uint64_t *next(const size_t words) {
+		assert(cursor + words <= static_cast<const uint64_t *>(mem) + length / sizeof(uint64_t));
+		const uint64_t *const p = cursor;
+		cursor += words;
+		return p;
+	}
+};
+
+// Serialization helpers: scalars are always written as 64-bit words, and vectors
+// of 64-bit elements in the format of util::Vector, so that all data is aligned.
+
+/** Writes a scalar as a 64-bit word. */
+template <typename T> void save(std::ostream &os, const T value) {
+	const uint64_t v = value;
+	os.write((char *)&v, sizeof v);
+}
+
+/** Writes a vector of 64-bit elements. */
+template <typename T, AllocType AT> void save(std::ostream &os, const Vector<T, AT> &vector) {
+	static_assert(sizeof(T) == sizeof(uint64_t), "Only vectors of 64-bit elements can be mapped");
+	os << vector;
+}
+
+/** Writes a bit vector in the format of util::Vector, followed by a zero
+ * word, so that rank(size()) can be computed on the deserialized copy.
+ *
+ * @param bits a bit vector of 64-bit words.
+ * @param num_bits the length (in bits) of the bit vector.
+ */
+inline void save_bits(std::ostream &os, const uint64_t *const bits, const uint64_t num_bits) {
+	const uint64_t num_words = (num_bits + 63) / 64, zero = 0;
+	save(os, num_words + 1);
+	os.write((char *)bits, num_words * sizeof(uint64_t));
+	os.write((char *)&zero, sizeof zero);
+}
+
+/** Reads a scalar written by save(). */
+template <typename T> void load(std::istream &is, T &value) {
+	uint64_t v;
+	is.read((char *)&v, sizeof v);
+	value = v;
+}
+
+/** Reads a vector written by save() or save_bits(). */
+template <typename T, AllocType AT> void load(std::istream &is, Vector<T, AT> &vector) { is >> vector; }
+
+/** Reads a scalar written by save() from a mapping. */
+template <typename T> void load(Mapping &mapping, T &value) { value = *mapping.next(1); }
+
+/** Makes a vector a view of a vector written by save() or save_bits() in a mapping. */
+template <typename T, AllocType AT> void load(Mapping &mapping, Vector<T, AT> &vector) {
+	const uint64_t length = *mapping.next(1);
+	vector = Vector<T, AT>::view(reinterpret_cast<const T *>(mapping.next(length)), length);
+}
+
+} // namespace sux::util
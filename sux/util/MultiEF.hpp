@@ -0,0 +1,349 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "Vector.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace sux::util {
+
+using namespace std;
+using namespace sux;
+
+/** A multiple Elias-Fano list.
+ *
+ * Instances of this class store `N` nondecreasing sequences of the same length,
+ * and retrieve the elements of given index of all sequences at once.
+ * The lower bits of the elements of the same index are interleaved, so they can usually be
+ * retrieved with a single unaligned read, whereas each sequence has its own upper bits.
+ *
+ * All sequences share a two-level jump table: for every 2<sup>`LOG2_SUPER_Q`</sup>
+ * elements we store the absolute position of the element in the upper bits of each sequence, and
+ * for every 2<sup>`LOG2_Q`</sup> elements its offset from the last absolute position.
+ * Offsets are stored using 16 bits whenever possible; larger
+ * widths are selected automatically at construction time if necessary.
+ *
+ * @tparam N the number of sequences.
+ * @tparam AT a type of memory allocation out of util::AllocType.
+ * @tparam LOG2_Q the base-2 logarithm of the distance between two consecutive offsets in the jump table.
+ * @tparam LOG2_SUPER_Q the base-2 logarithm of the distance between two consecutive absolute positions in the jump table.
+ */
+
+template <size_t N, util::AllocType AT = util::AllocType::MALLOC, int LOG2_Q = 8, int LOG2_SUPER_Q = 14> class MultiEF {
+	static_assert(N > 0, "N must be positive");
+	static_assert(LOG2_Q >= 0 && LOG2_Q <= LOG2_SUPER_Q && LOG2_SUPER_Q < 32, "LOG2_Q must be between 0 and LOG2_SUPER_Q, and LOG2_SUPER_Q smaller than 32");
+
+  protected:
+	static constexpr uint64_t log2q = LOG2_Q;
+	static constexpr uint64_t q = 1 << log2q;
+	static constexpr uint64_t q_mask = q - 1;
+	static constexpr uint64_t super_q = 1 << LOG2_SUPER_Q;
+	static constexpr uint64_t super_q_mask = super_q - 1;
+	static constexpr uint64_t q_per_super_q = super_q / q;
+	Vector<uint64_t, AT> lower_bits, upper_bits[N], jump;
+
+	uint64_t n = 0;
+	uint64_t u[N];
+	uint64_t l[N], lower_bits_mask[N], lower_bits_shift[N];
+	// The number of lower bits of the elements of the same index, and whether
+	// they can be read, together with the first lower bits of the next element, with a single unaligned read.
+	uint64_t l_sum;
+	bool single_read;
+	// Width in bytes of the offsets in the jump table (2, 4 or 8), and number of words of a whole block.
+	// Tables with offsets wider than 16 bits have an additional last word containing the width.
+	uint64_t offset_bytes, super_q_words;
+
+	__inline static void set(util::Vector<uint64_t, AT> &bits, const uint64_t pos) { bits[pos / 64] |= 1ULL << pos % 64; }
+
+	__inline static void set_bits(util::Vector<uint64_t, AT> &bits, const uint64_t start, const int width, const uint64_t value) {
+		const uint64_t mask = ((UINT64_C(1) << width) - 1) << start % 8;
+		uint64_t t;
+		memcpy(&t, (uint8_t *)&bits + start / 8, 8);
+		t = (t & ~mask) | value << start % 8;
+		memcpy((uint8_t *)&bits + start / 8, &t, 8);
+	}
+
+	__inline uint64_t get_bits(const uint64_t start, const uint64_t mask) const {
+		uint64_t t;
+		memcpy(&t, (uint8_t *)&lower_bits + start / 8, 8);
+		return t >> start % 8 & mask;
+	}
+
+	// Computes the number of lower bits and the related masks from n and u.
+	void init() {
+		l_sum = 0;
+		for (size_t j = 0; j < N; j++) {
+			l[j] = n == 0 || u[j] / n == 0 ? 0 : lambda(u[j] / n);
+			assert(l[j] <= 56);
+			lower_bits_mask[j] = (UINT64_C(1) << l[j]) - 1;
+			lower_bits_shift[j] = l_sum;
+			l_sum += l[j];
+		}
+		single_read = l_sum + l[0] <= 56;
+	}
+
+	__inline size_t lower_bits_size_words() const { return (n * l_sum + 63) / 64 + 1; }
+
+	__inline size_t upper_bits_size_words(const size_t j) const { return (n + (u[j] >> l[j]) + 63) / 64; }
+
+	// Words used by a block with the given number of offsets per sequence.
+	__inline static size_t block_words(const uint64_t offsets, const uint64_t offset_bytes) { return N * (1 + (offsets * offset_bytes + 7) / 8); }
+
+	__inline size_t jump_size_words(const uint64_t offset_bytes) const {
+		size_t size = (n / super_q) * block_words(q_per_super_q, offset_bytes);                 // Whole blocks
+		if (n % super_q != 0) size += block_words((n % super_q + q - 1) / q, offset_bytes); // Partial block
+		return size;
+	}
+
+	__inline size_t jump_size_words() const { return jump_size_words(offset_bytes); }
+
+	__inline void set_offset_bytes(const uint64_t offset_bytes) {
+		this->offset_bytes = offset_bytes;
+		super_q_words = block_words(q_per_super_q, offset_bytes);
+	}
+
+	// Returns the k-th offset of the block starting at the given word of the jump table.
+	__inline uint64_t jump_offset(const uint64_t jump_super_q, const uint64_t k) const {
+		const uint64_t *const offsets = &jump + jump_super_q + N;
+		if (likely(offset_bytes == 2)) return ((auint16_t *)offsets)[k];
+		if (offset_bytes == 4) return ((auint32_t *)offsets)[k];
+		return offsets[k];
+	}
+
+	__inline void set_jump_offset(const uint64_t jump_super_q, const uint64_t k, const uint64_t offset) {
+		uint64_t *const offsets = &jump + jump_super_q + N;
+		if (offset_bytes == 2)
+			((auint16_t *)offsets)[k] = offset;
+		else if (offset_bytes == 4)
+			((auint32_t *)offsets)[k] = offset;
+		else
+			offsets[k] = offset;
+	}
+
+	// Calls f(c, p) for the position p of each c-th one in the upper bits of the given sequence such that c is a multiple of q.
+	template <typename F> void for_each_q(const size_t j, F f) const {
+		for (uint64_t i = 0, c = 0, words = upper_bits_size_words(j); i < words; i++) {
+			const uint64_t window = upper_bits[j][i];
+			const uint64_t ones = nu(window);
+			for (uint64_t k = (q - (c & q_mask)) & q_mask; k < ones; k += q) f(c + k, i * 64 + select64(window, k));
+			c += ones;
+		}
+	}
+
+	// Fills the jump table for the given sequence.
+	void fill_jump(const size_t j) {
+		uint64_t last_super_q = 0;
+		for_each_q(j, [&](const uint64_t c, const uint64_t pos) {
+			const uint64_t jump_super_q = (c / super_q) * super_q_words;
+			if ((c & super_q_mask) == 0) jump[jump_super_q + j] = last_super_q = pos;
+			set_jump_offset(jump_super_q, N * ((c % super_q) / q) + j, pos - last_super_q);
+		});
+	}
+
+	// Returns the largest offset that would be stored in the jump table for the given sequence.
+	uint64_t max_jump_offset(const size_t j) const {
+		uint64_t last_super_q = 0, max = 0;
+		for_each_q(j, [&](const uint64_t c, const uint64_t pos) {
+			if ((c & super_q_mask) == 0) last_super_q = pos;
+			max = std::max(max, pos - last_super_q);
+		});
+		return max;
+	}
+
+	// Retrieves the elements of index i and, if NEXT is true, the element of index i + 1 of the first
+	// sequence; if SINGLE_READ is true, all lower bits are retrieved with a single unaligned read.
+	template <bool NEXT, bool SINGLE_READ> __inline void get(const uint64_t i, uint64_t *const values, uint64_t *const next) const {
+		const uint64_t pos_lower = i * l_sum;
+		uint64_t lower = 0;
+		if (SINGLE_READ) {
+			memcpy(&lower, (uint8_t *)&lower_bits + pos_lower / 8, 8);
+			lower >>= pos_lower % 8;
+		}
+
+		const uint64_t jump_super_q = (i / super_q) * super_q_words;
+		const uint64_t jump_inside_super_q = (i % super_q) / q;
+
+		uint64_t curr_word[N], window[N], delta[N];
+		for (size_t j = 0; j < N; j++) {
+			const uint64_t jump_pos = jump[jump_super_q + j] + jump_offset(jump_super_q, N * jump_inside_super_q + j);
+			curr_word[j] = jump_pos / 64;
+			window[j] = upper_bits[j][curr_word[j]] & UINT64_C(-1) << jump_pos % 64;
+			delta[j] = i & q_mask;
+		}
+
+		// Unrolling makes the scans independent, so they can proceed in parallel
+#pragma GCC unroll 16
+		for (size_t j = 0; j < N; j++)
+			for (uint64_t bit_count; (bit_count = nu(window[j])) <= delta[j]; delta[j] -= bit_count) window[j] = upper_bits[j][++curr_word[j]];
+
+		// Results are computed locally, as values might alias our fields
+		uint64_t result[N];
+		for (size_t j = 0; j < N; j++) {
+			delta[j] = select64(window[j], delta[j]);
+			uint64_t low;
+			if (SINGLE_READ) {
+				low = lower & lower_bits_mask[j];
+				lower >>= l[j];
+			} else
+				low = get_bits(pos_lower + lower_bits_shift[j], lower_bits_mask[j]);
+			result[j] = (curr_word[j] * 64 + delta[j] - i) << l[j] | low;
+		}
+
+		if (NEXT) {
+			window[0] &= (-1ULL << delta[0]) << 1;
+			while (window[0] == 0) window[0] = upper_bits[0][++curr_word[0]];
+			const uint64_t low = SINGLE_READ ? lower & lower_bits_mask[0] : get_bits(pos_lower + l_sum, lower_bits_mask[0]);
+			*next = (curr_word[0] * 64 + rho(window[0]) - i - 1) << l[0] | low;
+		}
+
+		for (size_t j = 0; j < N; j++) values[j] = result[j];
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const MultiEF &ef) {
+		os.write((char *)&ef.n, sizeof(ef.n));
+		os.write((char *)ef.u, sizeof(ef.u));
+		os.write((char *)&ef.offset_bytes, sizeof(ef.offset_bytes));
+		os << ef.lower_bits;
+		for (size_t j = 0; j < N; j++) os << ef.upper_bits[j];
+		os << ef.jump;
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, MultiEF &ef) {
+		is.read((char *)&ef.n, sizeof(ef.n));
+		is.read((char *)ef.u, sizeof(ef.u));
+		uint64_t offset_bytes;
+		is.read((char *)&offset_bytes, sizeof(offset_bytes));
+		ef.init();
+		ef.set_offset_bytes(offset_bytes);
+		is >> ef.lower_bits;
+		for (size_t j = 0; j < N; j++) is >> ef.upper_bits[j];
+		is >> ef.jump;
+		return is;
+	}
+
+  public:
+	MultiEF() {}
+
+	/** Creates a new instance using given sequences.
+	 *
+	 * Note that the sequences are read only at construction time.
+	 *
+	 * @param sequences `N` nondecreasing sequences of the same length.
+	 */
+	MultiEF(const std::array<std::vector<uint64_t>, N> &sequences) : n(sequences[0].size()) {
+		if (n == 0) {
+			for (size_t j = 0; j < N; j++) u[j] = 0;
+			init();
+			set_offset_bytes(2);
+			return;
+		}
+
+		for (size_t j = 0; j < N; j++) {
+			assert(sequences[j].size() == n);
+			u[j] = sequences[j][n - 1] + 1;
+		}
+		init();
+
+		lower_bits.size(lower_bits_size_words());
+		for (size_t j = 0; j < N; j++) {
+			upper_bits[j].size(upper_bits_size_words(j));
+			for (uint64_t i = 0; i < n; i++) {
+				const uint64_t v = sequences[j][i];
+				assert(i == 0 || v >= sequences[j][i - 1]);
+				if (l[j] != 0) set_bits(lower_bits, i * l_sum + lower_bits_shift[j], l[j], v & lower_bits_mask[j]);
+				set(upper_bits[j], (v >> l[j]) + i);
+			}
+		}
+
+		uint64_t max_offset = 0;
+		for (size_t j = 0; j < N; j++) max_offset = std::max(max_offset, max_jump_offset(j));
+		set_offset_bytes(max_offset < (UINT64_C(1) << 16) ? 2 : max_offset < (UINT64_C(1) << 32) ? 4 : 8);
+
+		const uint64_t jump_words = jump_size_words();
+		jump.size(jump_words + (offset_bytes != 2));
+		if (offset_bytes != 2) jump[jump_words] = offset_bytes;
+
+		for (size_t j = 0; j < N; j++) fill_jump(j);
+	}
+
+	/** Retrieves the elements of given index of all sequences.
+	 *
+	 * @param i an index between 0 (included) and size() (excluded).
+	 * @param values an array of `N` elements that will contain the elements of index `i`.
+	 */
+	void get(const uint64_t i, uint64_t *const values) const {
+		if (likely(single_read))
+			get<false, true>(i, values, nullptr);
+		else
+			get<false, false>(i, values, nullptr);
+	}
+
+	/** Retrieves the elements of given index of all sequences, and the following element of the first sequence.
+	 *
+	 * The additional element is usually retrieved at almost no cost.
+	 *
+	 * @param i an index between 0 (included) and size() - 1 (excluded).
+	 * @param values an array of `N` elements that will contain the elements of index `i`.
+	 * @param next will contain the element of index `i` + 1 of the first sequence.
+	 */
+	void get(const uint64_t i, uint64_t *const values, uint64_t &next) const {
+		if (likely(single_read))
+			get<true, true>(i, values, &next);
+		else
+			get<true, false>(i, values, &next);
+	}
+
+	/** Returns the elements of given index of all sequences.
+	 *
+	 * @param i an index between 0 (included) and size() (excluded).
+	 */
+	std::array<uint64_t, N> get(const uint64_t i) const {
+		std::array<uint64_t, N> values;
+		get(i, values.data());
+		return values;
+	}
+
+	/** Returns the length of the sequences. */
+	uint64_t size() const { return n; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	uint64_t bitCount() const {
+		uint64_t bits = lower_bits.bitCount() + jump.bitCount() - sizeof(lower_bits) * 8 - sizeof(jump) * 8;
+		for (size_t j = 0; j < N; j++) bits += upper_bits[j].bitCount() - sizeof(upper_bits[j]) * 8;
+		return bits + sizeof(*this) * 8;
+	}
+};
+
+} // namespace sux::util
@@ -0,0 +1,258 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../support/common.hpp"
+#include "Mapping.hpp"
+#include "Vector.hpp"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace sux::util {
+
+using namespace std;
+using namespace sux;
+
+/** A vector of integers of fixed bit width, packed in 64-bit words.
+ *
+ * Elements are stored one after the other using `width` bits each, with
+ * `width` between 0 and 64. Besides random access, ranges of elements
+ * can be decoded and encoded in bulk. Decoding uses AVX2 when the width is at most 32:
+ * since eight elements span exactly `width` bytes, pairs of elements are
+ * loaded in 128-bit lanes, moved to 64-bit lanes by a shuffle and aligned by a variable shift.
+ * Encoding accumulates elements in a buffer that is flushed a word at a time.
+ *
+ * AVX2 is used if the code is compiled for a target supporting it or if the host does (see sux::cpu_features).
+ *
+ * Instances can be serialized with the `<<` and `>>` operators, and a read-only
+ * view of a serialized instance can be created without copying from a util::Mapping.
+ *
+ * @tparam AT a type of memory allocation out of util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class PackedVector {
+  private:
+	// Free words at the end, so that unaligned and vector reads never cross the backing array
+	static constexpr size_t padding = 2;
+
+	size_t n = 0;
+	int width = 0;
+	uint64_t mask = 0;
+	util::Vector<uint64_t, AT> bits;
+
+	static size_t words(const size_t n, const int width) { return (n * width + 63) / 64 + padding; }
+
+	void save(std::ostream &os) const {
+		util::save(os, n);
+		util::save(os, width);
+		util::save(os, bits);
+	}
+
+	template <typename S> void load(S &src) {
+		util::load(src, n);
+		util::load(src, width);
+		util::load(src, bits);
+		mask = width == 64 ? -1ULL : (UINT64_C(1) << width) - 1;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const PackedVector<AT> &pv) {
+		pv.save(os);
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, PackedVector<AT> &pv) {
+		pv.load(is);
+		return is;
+	}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	// Decodes the given number of groups of eight elements starting at an element of index multiple of eight.
+	__attribute__((target("avx2"))) void decode_avx2(const size_t from, const size_t groups, uint64_t *out) const {
+		int byte[8];
+		alignas(32) uint8_t shuffle[2][32];
+		alignas(32) uint64_t shift[8];
+		for (int j = 0; j < 8; j++) {
+			byte[j] = j * width / 8;
+			shift[j] = j * width % 8;
+		}
+		// A lane loaded at the byte of the first element of a pair is shuffled so that its
+		// 64-bit halves start at the byte of each element, which is at most 4 bytes apart.
+		for (int k = 0; k < 4; k++)
+			for (int b = 0; b < 8; b++) {
+				shuffle[k / 2][k % 2 * 16 + b] = b;
+				shuffle[k / 2][k % 2 * 16 + 8 + b] = byte[2 * k + 1] - byte[2 * k] + b;
+			}
+
+		const __m256i shuffle_lo = _mm256_load_si256((const __m256i *)shuffle[0]), shuffle_hi = _mm256_load_si256((const __m256i *)shuffle[1]);
+		const __m256i shift_lo = _mm256_load_si256((const __m256i *)shift), shift_hi = _mm256_load_si256((const __m256i *)(shift + 4));
+		const __m256i m = _mm256_set1_epi64x(mask);
+		const uint8_t *p = (const uint8_t *)&bits + from / 8 * width;
+		for (size_t g = 0; g < groups; g++, p += width, out += 8) {
+			const __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(p + byte[0]))), _mm_loadu_si128((const __m128i *)(p + byte[2])), 1);
+			const __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(p + byte[4]))), _mm_loadu_si128((const __m128i *)(p + byte[6])), 1);
+			_mm256_storeu_si256((__m256i *)out, _mm256_and_si256(_mm256_srlv_epi64(_mm256_shuffle_epi8(lo, shuffle_lo), shift_lo), m));
+			_mm256_storeu_si256((__m256i *)(out + 4), _mm256_and_si256(_mm256_srlv_epi64(_mm256_shuffle_epi8(hi, shuffle_hi), shift_hi), m));
+		}
+	}
+#endif
+
+  public:
+	PackedVector() {}
+
+	/** Creates a new vector of given width and size, with all elements set to zero.
+	 *
+	 * @param width the number of bits of each element (between 0 and 64).
+	 * @param n the number of elements.
+	 */
+	explicit PackedVector(const int width, const size_t n = 0) : n(n), width(width), mask(width == 64 ? -1ULL : (UINT64_C(1) << width) - 1), bits(words(n, width)) { assert(width >= 0 && width <= 64); }
+
+	/** Creates a read-only view of an instance serialized in a mapping.
+	 *
+	 * @param mapping a mapping positioned at a serialized instance, which will be skipped.
+	 */
+	explicit PackedVector(util::Mapping &mapping) { load(mapping); }
+
+	/** Returns the element of given index. */
+	uint64_t get(const size_t i) const {
+		assert(i < n);
+		const uint64_t pos = i * width;
+		if (width <= 57) {
+			uint64_t word;
+			memcpy(&word, (const uint8_t *)&bits + pos / 8, sizeof word);
+			return word >> pos % 8 & mask;
+		}
+		const uint64_t *const word = &bits + pos / 64;
+		return (word[0] >> pos % 64 | word[1] << 1 << (63 - pos % 64)) & mask;
+	}
+
+	/** Sets the element of given index.
+	 *
+	 * @param i an index smaller than size().
+	 * @param value a value smaller than 2<sup>`width`</sup>.
+	 */
+	void set(const size_t i, const uint64_t value) {
+		assert(i < n);
+		assert((value & ~mask) == 0);
+		const uint64_t pos = i * width;
+		uint64_t *const word = &bits + pos / 64;
+		const int shift = pos % 64;
+		word[0] = (word[0] & ~(mask << shift)) | value << shift;
+		if (shift + width > 64) word[1] = (word[1] & ~(mask >> (64 - shift))) | value >> (64 - shift);
+	}
+
+	/** Adds an element at the end of this vector.
+	 *
+	 * @param value a value smaller than 2<sup>`width`</sup>.
+	 */
+	void pushBack(const uint64_t value) {
+		if (words(n + 1, width) > bits.size()) bits.resize(words(n + 1, width));
+		set(n++, value);
+	}
+
+	/** Changes the number of elements; new elements are set to zero. */
+	void resize(const size_t size) {
+		if (size < n) {
+			// Clears the bits of removed elements, so that they are zero if the vector grows again
+			const uint64_t pos = size * width;
+			bits[pos / 64] &= (UINT64_C(1) << pos % 64) - 1;
+			std::fill(&bits + pos / 64 + 1, &bits + bits.size(), 0);
+		}
+		bits.resize(words(size, width));
+		n = size;
+	}
+
+	/** Decodes a range of elements.
+	 *
+	 * @param from the index of the first element.
+	 * @param to the index after the last element.
+	 * @param out an array of `to - from` elements that will be filled with the decoded elements.
+	 */
+	void decode(size_t from, const size_t to, uint64_t *out) const {
+		assert(from <= to && to <= n);
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#ifdef __AVX2__
+		const bool avx2 = true;
+#else
+		const bool avx2 = cpu_features.avx2;
+#endif
+		if (avx2 && width != 0 && width <= 32 && to - from >= 16) {
+			for (; from % 8 != 0; from++) *out++ = get(from);
+			const size_t groups = (to - from) / 8;
+			decode_avx2(from, groups, out);
+			from += groups * 8;
+			out += groups * 8;
+		}
+#endif
+		for (; from < to; from++) *out++ = get(from);
+	}
+
+	/** Encodes a range of elements.
+	 *
+	 * @param from the index of the first element to be set.
+	 * @param in an array of `len` elements smaller than 2<sup>`width`</sup>.
+	 * @param len the number of elements to be set; `from + len` must not be larger than size().
+	 */
+	void encode(const size_t from, const uint64_t *const in, const size_t len) {
+		assert(from + len <= n);
+		if (width == 0 || len == 0) return;
+		if (width == 64) {
+			memcpy(&bits + from, in, len * sizeof(uint64_t));
+			return;
+		}
+
+		const uint64_t pos = from * width;
+		uint64_t *word = &bits + pos / 64;
+		int filled = pos % 64;
+		uint64_t buffer = *word & ((UINT64_C(1) << filled) - 1);
+		for (size_t i = 0; i < len; i++) {
+			const uint64_t value = in[i];
+			assert((value & ~mask) == 0);
+			buffer |= value << filled;
+			filled += width;
+			if (filled >= 64) {
+				*word++ = buffer;
+				filled -= 64;
+				buffer = filled == 0 ? 0 : value >> (width - filled);
+			}
+		}
+		if (filled != 0) *word = (*word & -(UINT64_C(1) << filled)) | buffer;
+	}
+
+	/** Returns the number of elements. */
+	size_t size() const { return n; }
+
+	/** Returns the number of bits of each element. */
+	int getWidth() const { return width; }
+
+	/** Returns an estimate of the size in bits of this vector. */
+	size_t bitCount() const { return bits.bitCount() - sizeof(bits) * 8 + sizeof(*this) * 8; }
+};
+
+} // namespace sux::util
@@ -0,0 +1,220 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../function/RiceBitVector.hpp"
+#include "../support/common.hpp"
+#include "Vector.hpp"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace sux::util {
+
+using namespace std;
+using namespace sux;
+
+/** A monotone sequence of integers stored as Golomb-Rice coded gaps.
+ *
+ * The gaps between consecutive elements (the first element is
+ * the gap from zero) are coded using a single Golomb-Rice
+ * parameter, which is chosen at construction time so to minimize
+ * the overall space. Gaps are grouped in blocks of 2<sup>`log2_sample`</sup>
+ * elements, laid out as in a RecSplit bucket of sux::function::RiceBitVector
+ * (fixed parts first, then unary parts); for each block we store its
+ * starting bit position and the value of the element preceding it.
+ *
+ * Random access decodes at most a block; sequential access
+ * through an Iterator decodes a whole block at a time using
+ * sux::function::RiceBitVector::decodeAll().
+ *
+ * This representation is competitive with bits::EliasFano when gaps are
+ * approximately geometrically distributed, and in particular when they are small.
+ *
+ * @tparam AT a type of memory allocation out of util::AllocType.
+ */
+
+template <util::AllocType AT = util::AllocType::MALLOC> class RiceSequence {
+  private:
+	size_t n = 0;
+	int log2golomb = 0;
+	int log2_sample = 0;
+	sux::function::RiceBitVector<AT> codes;
+	// For each block, the bit position of its first fixed part and the value preceding the block.
+	util::Vector<uint64_t, AT> samples;
+
+	// The number of bits used to code the given gaps with the given Golomb-Rice parameter.
+	static uint64_t cost(const std::vector<uint64_t> &gaps, const int log2golomb) {
+		uint64_t bits = gaps.size() * uint64_t(log2golomb + 1);
+		for (const auto g : gaps) bits += g >> log2golomb;
+		return bits;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const RiceSequence<AT> &rs) {
+		const uint64_t n = rs.n;
+		os.write((char *)&n, sizeof(uint64_t));
+		os.write((char *)&rs.log2golomb, sizeof(rs.log2golomb));
+		os.write((char *)&rs.log2_sample, sizeof(rs.log2_sample));
+		os << rs.codes;
+		os << rs.samples;
+		return os;
+	}
+
+	friend std::istream &operator>>(std::istream &is, RiceSequence<AT> &rs) {
+		uint64_t n;
+		is.read((char *)&n, sizeof(uint64_t));
+		rs.n = n;
+		is.read((char *)&rs.log2golomb, sizeof(rs.log2golomb));
+		is.read((char *)&rs.log2_sample, sizeof(rs.log2_sample));
+		is >> rs.codes;
+		is >> rs.samples;
+		return is;
+	}
+
+  public:
+	RiceSequence() {}
+
+	/** Creates a new instance using a given monotone sequence.
+	 *
+	 * Note that the sequence is read only at construction time.
+	 *
+	 * @param values a nondecreasing sequence of integers.
+	 * @param log2_sample the base-2 logarithm of the number of elements
+	 * between two consecutive samples; larger values save space, but make
+	 * random access slower.
+	 */
+	RiceSequence(const std::vector<uint64_t> &values, const int log2_sample = 6) : n(values.size()), log2_sample(log2_sample) {
+		std::vector<uint64_t> gaps(n);
+		for (size_t i = 0; i < n; i++) {
+			assert(i == 0 || values[i] >= values[i - 1]);
+			gaps[i] = values[i] - (i == 0 ? 0 : values[i - 1]);
+		}
+
+		// The optimal parameter for a geometric distribution is close to the logarithm of the average gap
+		const int center = n == 0 ? 0 : max(0, lambda_safe(values[n - 1] / n));
+		uint64_t best = UINT64_MAX;
+		for (int k = max(0, center - 1); k <= min(56, center + 1); k++) {
+			const uint64_t c = cost(gaps, k);
+			if (c < best) {
+				best = c;
+				log2golomb = k;
+			}
+		}
+
+		const size_t sample = size_t(1) << log2_sample;
+		const size_t num_blocks = (n + sample - 1) / sample;
+		samples.size(num_blocks * 2);
+
+		typename sux::function::RiceBitVector<AT>::Builder builder;
+		builder.reserve(best);
+
+		for (size_t b = 0; b < num_blocks; b++) {
+			const size_t start = b << log2_sample;
+			samples[2 * b] = builder.getBits();
+			samples[2 * b + 1] = start == 0 ? 0 : values[start - 1];
+			builder.appendBucket(&gaps[start], log2golomb, min(sample, n - start));
+		}
+
+		codes = builder.build();
+	}
+
+	/** Returns the element of given index.
+	 *
+	 * @param i an index between 0 (included) and size() (excluded).
+	 * @return the element of index `i`.
+	 */
+	uint64_t get(const size_t i) {
+		assert(i < n);
+		const size_t block = i >> log2_sample;
+		const size_t start = block << log2_sample;
+		const size_t len = min(size_t(1) << log2_sample, n - start);
+
+		auto reader = codes.reader();
+		reader.readReset(samples[2 * block], len * log2golomb);
+		uint64_t value = samples[2 * block + 1];
+		for (size_t j = i - start + 1; j-- != 0;) value += reader.readNext(log2golomb);
+		return value;
+	}
+
+	/** An iterator returning elements in sequence.
+	 *
+	 * Elements are decoded a block at a time in an internal buffer.
+	 */
+	class Iterator {
+		const RiceSequence<AT> &seq;
+		std::vector<uint64_t> buffer;
+		size_t index, pos = 0, fill = 0;
+
+		void decodeBlock() {
+			const size_t block = index >> seq.log2_sample;
+			const size_t start = block << seq.log2_sample;
+			fill = min(buffer.size(), seq.n - start);
+			seq.codes.decodeAll(seq.samples[2 * block], seq.log2golomb, fill, buffer.data());
+			uint64_t value = seq.samples[2 * block + 1];
+			for (size_t j = 0; j < fill; j++) buffer[j] = value += buffer[j];
+			pos = index - start;
+		}
+
+	  public:
+		Iterator(const RiceSequence<AT> &seq, const size_t from) : seq(seq), buffer(size_t(1) << seq.log2_sample), index(from) {
+			if (index < seq.n) decodeBlock();
+		}
+
+		/** Returns whether there are more elements to return. */
+		bool hasNext() const { return index < seq.n; }
+
+		/** Returns the index of the element that will be returned by next(). */
+		size_t nextIndex() const { return index; }
+
+		/** Returns the next element. */
+		uint64_t next() {
+			assert(hasNext());
+			if (pos == fill) decodeBlock();
+			index++;
+			return buffer[pos++];
+		}
+	};
+
+	/** Returns an iterator starting at a given index.
+	 *
+	 * @param from the index of the first element returned by the iterator.
+	 */
+	Iterator iterator(const size_t from = 0) const { return Iterator(*this, from); }
+
+	/** Returns the Golomb-Rice parameter used by this sequence. */
+	int getLog2Golomb() const { return log2golomb; }
+
+	/** Returns the number of elements of this sequence. */
+	size_t size() const { return n; }
+
+	/** Returns an estimate of the size in bits of this structure. */
+	size_t bitCount() const { return codes.getBits() + samples.bitCount() - sizeof(samples) * 8 + sizeof(*this) * 8 - sizeof(codes) * 8; }
+};
+
+} // namespace sux::util
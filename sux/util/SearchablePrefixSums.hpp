@@ -28,8 +28,10 @@
 
 #pragma once
 
+#include "../support/parallel.hpp"
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace sux::util {
 
@@ -108,6 +110,19 @@ class SearchablePrefixSums {
 	 */
 	virtual void push(uint64_t val) = 0;
 
+	/** Append a sequence of values to the sequence.
+	 *
+	 * @param seq values to append.
+	 * @param n the number of values.
+	 *
+	 * The result is the same as calling `push(seq[i])` for `i`
+	 * from 0 to `n`, excluded. Implementations may allocate space once
+	 * and compute the new nodes in a single sweep.
+	 */
+	virtual void append(const uint64_t seq[], size_t n) {
+		for (size_t i = 0; i < n; i++) push(seq[i]);
+	}
+
 	/** Remove the last value of the sequence.
 	 *
 	 * This method does not release the allocated space.
@@ -119,6 +134,132 @@ class SearchablePrefixSums {
 
 	/** Returns an estimate of the size (in bits) of this structure. */
 	virtual size_t bitCount() const = 0;
+
+	/** Increment a batch of elements of the sequence.
+	 *
+	 * @param idx indices of the elements.
+	 * @param inc values to sum.
+	 * @param n the number of increments.
+	 *
+	 * The result is the same as calling `add(idx[i], inc[i])` for `i`
+	 * from 0 to `n`, excluded; indices may be repeated and need not be sorted.
+	 * Implementations may merge the updates so that each internal node is modified once.
+	 */
+	virtual void addBatch(const size_t idx[], const int64_t inc[], size_t n) {
+		for (size_t i = 0; i < n; i++) add(idx[i], inc[i]);
+	}
+
+	/** Compute a batch of prefix sums.
+	 *
+	 * @param length lengths of the prefix sums (from 0 to size(), included).
+	 * @param out an array of `n` elements that will be filled with `prefix(length[i])`.
+	 * @param n the number of prefix sums.
+	 *
+	 * Implementations may prefetch the data needed by later queries in the batch.
+	 */
+	virtual void prefixBatch(const size_t length[], uint64_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) out[i] = prefix(length[i]);
+	}
+
+	/** Search a batch of bounds.
+	 *
+	 * @param val bounds for the prefix sums; each bound will be replaced with its excess, as in find(uint64_t *).
+	 * @param out an array of `n` elements that will be filled with the results of `find(&val[i])`.
+	 * @param n the number of bounds.
+	 *
+	 * Implementations may interleave the searches so that memory accesses of different searches overlap.
+	 */
+	virtual void findBatch(uint64_t val[], size_t out[], size_t n) {
+		for (size_t i = 0; i < n; i++) out[i] = find(&val[i]);
+	}
+
+  protected:
+	/** The number of queries interleaved (or prefetched in advance) by batch methods. */
+	static constexpr size_t BATCH_GROUP = 16;
+
+	/** The length of the aligned blocks of indices built by a thread in a parallel Fenwick-tree construction. */
+	static constexpr size_t BUILD_BLOCK = 1 << 16;
+
+	/** Nodes whose index is a multiple of this value are built sequentially after the blocks. */
+	static constexpr size_t BUILD_SPLIT = 1 << 8;
+
+	/** Apply a batch of increments to a Fenwick tree.
+	 *
+	 * Sparse batches are applied one increment at a time, as updates are independent and
+	 * their memory accesses overlap. In dense batches (at least one increment every
+	 * sixteen elements) increments are accumulated by index and then propagated to the
+	 * ancestors in a single sweep in index order, so each node is modified at most once and
+	 * memory is accessed sequentially.
+	 *
+	 * @param idx indices of the elements.
+	 * @param inc values to sum.
+	 * @param n the number of increments.
+	 * @param size the size of the tree.
+	 * @param node_add a function adding its second argument to the node of index given by its first argument.
+	 */
+	template <typename F> static void fenwickAddBatch(const size_t idx[], const int64_t inc[], size_t n, size_t size, F &&node_add) {
+		if (n < size / 16) {
+			for (size_t i = 0; i < n; i++)
+				for (size_t j = idx[i]; j <= size; j += j & -j) node_add(j, inc[i]);
+			return;
+		}
+
+		std::unique_ptr<int64_t[]> delta(new int64_t[size + 1]());
+		for (size_t i = 0; i < n; i++)
+			if (idx[i] <= size) delta[idx[i]] += inc[i];
+
+		for (size_t j = 1; j <= size; j++) {
+			if (delta[j] == 0) continue;
+			node_add(j, delta[j]);
+			const size_t parent = j + (j & -j);
+			if (parent <= size) delta[parent] += delta[j];
+		}
+	}
+
+	/** Compute a range of nodes of a Fenwick tree.
+	 *
+	 * Node `j` contains element `j` plus its children `j - 1`, `j - 2`, `j - 4`, &hellip;, up to
+	 * `j - 2^rho(j) / 2`, so computing nodes in index order needs just children that are already in
+	 * place; as each node is written (not incremented) once, stale data in the tree are harmless.
+	 *
+	 * With more than one thread (and at least ::BUILD_BLOCK nodes), nodes whose index is not a
+	 * multiple of ::BUILD_SPLIT depend only on nodes of the same aligned block of ::BUILD_BLOCK
+	 * indices, and they are computed in parallel, first in even and then in odd blocks: concurrent
+	 * writes are thus a block apart, and they do not interfere even when nodes are packed in bytes
+	 * or bits. The remaining nodes are computed sequentially at the end.
+	 *
+	 * @param seq the elements of index `from + 1`, `from + 2`, &hellip;, `to`.
+	 * @param from the index of the last node already in place.
+	 * @param to the index of the last node to compute.
+	 * @param threads the number of threads.
+	 * @param get a function returning the node of index given by its argument.
+	 * @param set a function setting the node of index given by its first argument to its second argument.
+	 */
+	template <typename G, typename S> static void fenwickBuild(const uint64_t seq[], size_t from, size_t to, int threads, G &&get, S &&set) {
+		const auto node = [&](size_t j) {
+			uint64_t value = seq[j - from - 1];
+			for (size_t k = 1; k < (j & -j); k <<= 1) value += get(j - k);
+			set(j, value);
+		};
+
+		if (threads <= 1 || to - from < BUILD_BLOCK) {
+			for (size_t j = from + 1; j <= to; j++) node(j);
+			return;
+		}
+
+		const size_t first = from / BUILD_BLOCK, blocks = (to - 1) / BUILD_BLOCK + 1 - first;
+		for (size_t parity = 0; parity < 2; parity++) {
+			parallel_slices((blocks + 1 - parity) / 2, threads, [&](const int, const uint64_t begin, const uint64_t end) {
+				for (uint64_t b = begin; b < end; b++) {
+					const size_t start = (first + 2 * b + parity) * BUILD_BLOCK;
+					for (size_t j = std::max(start, from) + 1; j <= std::min(start + BUILD_BLOCK, to); j++)
+						if (j % BUILD_SPLIT != 0) node(j);
+				}
+			});
+		}
+
+		for (size_t j = (from / BUILD_SPLIT + 1) * BUILD_SPLIT; j <= to; j += BUILD_SPLIT) node(j);
+	}
 };
 
 } // namespace sux::util
@@ -0,0 +1,149 @@
+/*
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2019-2020 Emmanuel Esposito and Sebastiano Vigna
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional permissions
+ * described in the GCC Runtime Library Exception, version 3.1, as published by
+ * the Free Software Foundation.
+ *
+ * You should have received a copy of the GNU General Public License and a copy of
+ * the GCC Runtime Library Exception along with this program; see the files
+ * COPYING3 and COPYING.RUNTIME respectively.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../bits/EliasFano.hpp"
+#include "SearchablePrefixSums.hpp"
+#include <vector>
+
+namespace sux::util {
+
+/** Static searchable prefix sums based on the Elias-Fano representation of cumulative sums.
+ *
+ * The prefix sums of the sequence are stored, with duplicates, in a sux::bits::EliasFano
+ * instance, so prefix() is a single selection and find() is a single ranking (plus a selection
+ * to compute the excess); compFind() performs a binary search using selections.
+ *
+ * This structure is meant for read-mostly workloads: add(), push() and pop() rebuild
+ * the whole structure in linear time. It can be plugged in sux::bits::WordDynRankSel
+ * and sux::bits::StrideDynRankSel as a searchable prefix-sum structure for bit vectors that are rarely modified.
+ *
+ * @tparam BOUND maximum representable value (at most the maximum value of a `uint64_t`).
+ * @tparam AT a type of memory allocation out of ::AllocType.
+ */
+
+template <size_t BOUND, AllocType AT = MALLOC> class StaticPrefixSums : public SearchablePrefixSums {
+  protected:
+	bits::EliasFano<AT> Sums;
+	size_t Size;
+
+  public:
+	/** Creates a new instance with no values (empty sequence). */
+	StaticPrefixSums() : Size(0) {}
+
+	/** Creates a new instance with given vector of values.
+	 *
+	 * Note that the provided sequence is read at construction time but
+	 * it will not be referenced afterwards.
+	 *
+	 * @param sequence a sequence of nonnegative integers smaller than or equal to the template parameter `BOUND`.
+	 * @param size the number of elements in the sequence.
+	 */
+	StaticPrefixSums(const uint64_t sequence[], size_t size) {
+		std::vector<uint64_t> sums(size);
+		uint64_t sum = 0;
+		for (size_t i = 0; i < size; i++) sums[i] = sum += sequence[i];
+		build(sums);
+	}
+
+	virtual uint64_t prefix(size_t length) { return length == 0 ? 0 : Sums.select(length - 1); }
+
+	/** Increments an element of the sequence, rebuilding the structure in linear time. */
+	virtual void add(size_t idx, int64_t inc) {
+		std::vector<uint64_t> sums = decode();
+		for (size_t i = idx - 1; i < Size; i++) sums[i] += inc;
+		build(sums);
+	}
+
+	using SearchablePrefixSums::find;
+	virtual size_t find(uint64_t *val) {
+		// The number of prefix sums (of positive length) smaller than or equal to *val
+		const size_t length = *val == UINT64_MAX ? Size : Sums.rank(*val + 1);
+		*val -= prefix(length);
+		return length;
+	}
+
+	using SearchablePrefixSums::compFind;
+	virtual size_t compFind(uint64_t *val) {
+		// Complemented prefix sums are nondecreasing, as elements are at most BOUND
+		size_t lo = 0, hi = Size + 1;
+		while (hi - lo > 1) {
+			const size_t mid = (lo + hi) / 2;
+			if (BOUND * mid - prefix(mid) <= *val)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		*val -= BOUND * lo - prefix(lo);
+		return lo;
+	}
+
+	/** Appends a value to the sequence, rebuilding the structure in linear time. */
+	virtual void push(uint64_t val) {
+		std::vector<uint64_t> sums = decode();
+		sums.push_back(prefix(Size) + val);
+		build(sums);
+	}
+
+	/** Removes the last value of the sequence, rebuilding the structure in linear time. */
+	virtual void pop() {
+		std::vector<uint64_t> sums = decode();
+		sums.pop_back();
+		build(sums);
+	}
+
+	virtual size_t size() const { return Size; }
+
+	virtual size_t bitCount() const { return Sums.bitCount() - sizeof(Sums) * 8 + sizeof(*this) * 8; }
+
+  private:
+	void build(const std::vector<uint64_t> &sums) {
+		Size = sums.size();
+		Sums = bits::EliasFano<AT>(sums, (Size == 0 ? 0 : sums[Size - 1]) + 1);
+	}
+
+	std::vector<uint64_t> decode() {
+		std::vector<uint64_t> sums(Size);
+		auto it = Sums.iterator();
+		for (size_t i = 0; i < Size; i++) sums[i] = it.next();
+		return sums;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const StaticPrefixSums<BOUND, AT> &sps) {
+		os.write((char *)&sps.Size, sizeof(uint64_t));
+		return os << sps.Sums;
+	}
+
+	friend std::istream &operator>>(std::istream &is, StaticPrefixSums<BOUND, AT> &sps) {
+		is.read((char *)&sps.Size, sizeof(uint64_t));
+		return is >> sps.Sums;
+	}
+};
+
+} // namespace sux::util
@@ -72,6 +72,9 @@ enum AllocType {
  * This class implements the standard `<<` and `>>` operators for simple
  * serialization and deserialization.
  *
+ * A vector can also be a read-only view of an array it does not own
+ * (see view()), such as a part of a memory-mapped file.
+ *
  * @tparam T the data type of an element.
  * @tparam AT a type of memory allocation out of ::AllocType.
  */
@@ -97,10 +100,26 @@ template <typename T, AllocType AT = MALLOC> class Vector : public Expandable {
 
 	explicit Vector(size_t length) { size(length); }
 
-	explicit Vector(const T *data, size_t length) : Vector(length) { memcpy(this->data, data, length); }
+	explicit Vector(const T *data, size_t length) : Vector(length) { memcpy(this->data, data, length * sizeof(T)); }
+
+	/** Creates a read-only view of an array.
+	 *
+	 * The array is neither copied nor freed: it must outlive the view,
+	 * and the view must not be modified or resized.
+	 *
+	 * @param data an array.
+	 * @param length the number of elements of the array.
+	 */
+	static Vector<T, AT> view(const T *data, size_t length) {
+		Vector<T, AT> v;
+		v._size = length;
+		v.data = const_cast<T *>(data);
+		return v;
+	}
 
 	~Vector() {
-		if (data) {
+		// Views have no capacity
+		if (data && _capacity != 0) {
 			if (AT == MALLOC) {
 				free(data);
 			} else {
@@ -232,11 +251,12 @@ template <typename T, AllocType AT = MALLOC> class Vector : public Expandable {
 	size_t bitCount() const { return sizeof(*this) * 8 + _capacity * sizeof(T) * 8; }
 
   private:
+	// Rounds a number of bytes to a multiple of the page size
 	static size_t page_aligned(size_t size) {
 		if (AT == FORCEHUGEPAGE)
-			return ((2 * 1024 * 1024 - 1) | (size * sizeof(T) - 1)) + 1;
+			return ((2 * 1024 * 1024 - 1) | (size - 1)) + 1;
 		else
-			return ((4 * 1024 - 1) | (size * sizeof(T) - 1)) + 1;
+			return ((4 * 1024 - 1) | (size - 1)) + 1;
 	}
 
 	void remap(size_t size) {
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <sux/bits/BalancedParentheses.hpp>
+#include <vector>
+
+static void run_balanced_parentheses(const std::vector<bool> &par) {
+	using namespace sux::bits;
+	const uint64_t n = par.size();
+	std::vector<uint64_t> bits((n + 63) / 64 + 1);
+	for (uint64_t i = 0; i < n; i++)
+		if (par[i]) bits[i / 64] |= UINT64_C(1) << i % 64;
+
+	// Matching and enclosing pairs, computed with a stack
+	std::vector<uint64_t> match(n), enclose(n), stack;
+	std::vector<int64_t> excess(n);
+	for (uint64_t i = 0; i < n; i++) {
+		if (par[i]) {
+			enclose[i] = stack.empty() ? n : stack.back();
+			stack.push_back(i);
+		} else {
+			match[i] = stack.back();
+			match[stack.back()] = i;
+			stack.pop_back();
+		}
+		excess[i] = stack.size();
+	}
+	ASSERT_TRUE(stack.empty());
+
+	BalancedParentheses bp(bits.data(), n);
+	ASSERT_EQ(n, bp.size());
+	ASSERT_EQ(n / 2, bp.numNodes());
+	for (uint64_t i = 0; i < n; i++) {
+		ASSERT_EQ(par[i], bp.isOpen(i)) << "at position " << i;
+		ASSERT_EQ(excess[i], bp.excess(i)) << "at position " << i;
+		if (par[i]) {
+			ASSERT_EQ(match[i], bp.findClose(i)) << "at position " << i;
+			ASSERT_EQ(enclose[i], bp.enclose(i)) << "at position " << i;
+		} else
+			ASSERT_EQ(match[i], bp.findOpen(i)) << "at position " << i;
+	}
+
+	// Tree navigation
+	for (uint64_t k = 0; k < n / 2; k++) {
+		const uint64_t v = bp.node(k);
+		ASSERT_TRUE(par[v]);
+		ASSERT_EQ(k, bp.preorder(v));
+		ASSERT_EQ(enclose[v], bp.parent(v));
+		ASSERT_EQ(uint64_t(excess[v]), bp.depth(v));
+		ASSERT_EQ((match[v] - v + 1) / 2, bp.subtreeSize(v));
+		ASSERT_EQ(!par[v + 1], bp.isLeaf(v));
+		ASSERT_EQ(par[v + 1] ? v + 1 : n, bp.firstChild(v));
+		ASSERT_EQ(match[v] + 1 < n && par[match[v] + 1] ? match[v] + 1 : n, bp.nextSibling(v));
+	}
+}
+
+// A random balanced sequence with the given number of pairs; the probability of opening drives the depth
+static std::vector<bool> random_parentheses(const uint64_t pairs, const uint64_t open_per_mille) {
+	std::vector<bool> par;
+	uint64_t open = 0, depth = 0;
+	while (open < pairs || depth > 0) {
+		if (open < pairs && (depth == 0 || next() % 1000 < open_per_mille)) {
+			par.push_back(true);
+			open++;
+			depth++;
+		} else {
+			par.push_back(false);
+			depth--;
+		}
+	}
+	return par;
+}
+
+TEST(balancedparentheses, small) {
+	run_balanced_parentheses({});
+	run_balanced_parentheses({true, false});
+	run_balanced_parentheses({true, true, false, true, false, false, true, false});
+}
+
+TEST(balancedparentheses, random) {
+	for (uint64_t pairs : {10, 100, 1000, 31, 32, 33, 100000})
+		for (uint64_t p : {300, 500, 700}) run_balanced_parentheses(random_parentheses(pairs, p));
+}
+
+TEST(balancedparentheses, extreme) {
+	for (uint64_t pairs : {1000, 100000}) {
+		// A path: matching pairs are far apart, so the searches cross many blocks
+		std::vector<bool> par(2 * pairs);
+		for (uint64_t i = 0; i < pairs; i++) par[i] = true;
+		run_balanced_parentheses(par);
+		// A star and a forest of leaves
+		for (uint64_t i = 0; i < 2 * pairs; i++) par[i] = i % 2 == 0;
+		run_balanced_parentheses(par);
+		par.insert(par.begin(), true);
+		par.push_back(false);
+		run_balanced_parentheses(par);
+	}
+}
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <sux/util/BAryPrefixSums.hpp>
 #include <sux/util/FenwickBitF.hpp>
 #include <sux/util/FenwickBitL.hpp>
 #include <sux/util/FenwickByteF.hpp>
 #include <sux/util/FenwickByteL.hpp>
 #include <sux/util/FenwickFixedF.hpp>
 #include <sux/util/FenwickFixedL.hpp>
+#include <sux/util/FenwickHybrid.hpp>
+#include <sux/util/StaticPrefixSums.hpp>
+#include <vector>
 
 #include <sux/bits/StrideDynRankSel.hpp>
 #include <sux/bits/WordDynRankSel.hpp>
@@ -432,3 +436,53 @@ TEST(dynranksel, stride) {
 		run_dynranksel<1024>(i);
 	}
 }
+
+// Checks ranking and selection using a given searchable prefix-sum structure against FenwickFixedF.
+template <template <size_t, sux::util::AllocType> class SPS> static void run_dynranksel_sps(const size_t size, const size_t updates) {
+	using namespace sux;
+	std::vector<uint64_t> bv(size / 64 + 1), bv_word(size / 64 + 1), bv_stride(size / 64 + 1);
+	for (size_t i = 0; i < (size + 63) / 64; i++) bv[i] = next() & next();
+	if (size % 64 != 0) bv[size / 64] &= (UINT64_C(1) << size % 64) - 1;
+	bv_word = bv;
+	bv_stride = bv;
+
+	bits::WordDynRankSel<util::FenwickFixedF> ref(bv.data(), size);
+	bits::WordDynRankSel<SPS> word(bv_word.data(), size);
+	bits::StrideDynRankSel<SPS, 4> stride(bv_stride.data(), size);
+
+	for (size_t u = 0; u <= updates; u++) {
+		const uint64_t ones = ref.rank(size), zeros = size - ones;
+		for (size_t i = 0; i <= size; i++) {
+			ASSERT_EQ(ref.rank(i), word.rank(i)) << "at index " << i;
+			ASSERT_EQ(ref.rank(i), stride.rank(i)) << "at index " << i;
+		}
+		for (uint64_t r = 0; r < ones; r++) {
+			ASSERT_EQ(ref.select(r), word.select(r)) << "at rank " << r;
+			ASSERT_EQ(ref.select(r), stride.select(r)) << "at rank " << r;
+		}
+		for (uint64_t r = 0; r < zeros; r++) {
+			ASSERT_EQ(ref.selectZero(r), word.selectZero(r)) << "at rank " << r;
+			ASSERT_EQ(ref.selectZero(r), stride.selectZero(r)) << "at rank " << r;
+		}
+		if (size == 0) break;
+		const size_t pos = next() % size;
+		ref.toggle(pos);
+		word.toggle(pos);
+		stride.toggle(pos);
+	}
+}
+
+TEST(dynranksel, static_prefix_sums) {
+	for (size_t size : {0, 1, 64, 1000, 100000}) run_dynranksel_sps<sux::util::StaticPrefixSums>(size, 3);
+}
+
+TEST(dynranksel, fenwick_hybrid) {
+	for (size_t size : {0, 1, 64, 1000, 100000}) {
+		run_dynranksel_sps<sux::util::FenwickHybridSplit<1>::type>(size, 100);
+		run_dynranksel_sps<sux::util::FenwickHybridSplit<4>::type>(size, 100);
+	}
+}
+
+TEST(dynranksel, bary_prefix_sums) {
+	for (size_t size : {0, 1, 64, 1000, 100000}) run_dynranksel_sps<sux::util::BAryPrefixSums>(size, 100);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <sux/bits/EliasFano.hpp>
+#include <sux/bits/PartitionedEliasFano.hpp>
+#include <vector>
+
+// Clusters of dense positions separated by large gaps
+static std::vector<uint64_t> clustered_ones(const size_t num_ones, const uint64_t max_gap, const uint64_t max_jump) {
+	std::vector<uint64_t> ones(num_ones);
+	for (size_t i = 0; i < num_ones; i++) {
+		const uint64_t gap = next() % 1000 == 0 ? next() % max_jump : next() % max_gap;
+		ones[i] = (i == 0 ? 0 : ones[i - 1] + 1) + gap;
+	}
+	return ones;
+}
+
+static void run_partitioned_elias_fano(const std::vector<uint64_t> &ones, const uint64_t num_bits) {
+	using namespace sux::bits;
+	const size_t num_ones = ones.size();
+	PartitionedEliasFano pef(ones, num_bits);
+
+	std::vector<uint64_t> bits(num_bits / 64 + 1);
+	for (auto o : ones) bits[o / 64] |= UINT64_C(1) << o % 64;
+	PartitionedEliasFano pef2(bits.data(), num_bits);
+	ASSERT_EQ(pef.bitCount(), pef2.bitCount());
+	ASSERT_EQ(num_bits, pef.size());
+
+	for (size_t i = 0; i < num_ones; i++) ASSERT_EQ(ones[i], pef.select(i)) << "at index " << i;
+
+	for (uint64_t pos = 0, r = 0; pos <= num_bits; pos += 1 + next() % (16 + num_bits / (num_ones + 1))) {
+		while (r < num_ones && ones[r] < pos) r++;
+		ASSERT_EQ(r, pef.rank(pos)) << "at position " << pos;
+		ASSERT_EQ(r, pef2.rank(pos)) << "at position " << pos;
+	}
+	for (size_t i = 0; i < num_ones; i++) {
+		ASSERT_EQ(i, pef.rank(ones[i])) << "at index " << i;
+		ASSERT_EQ(i + 1, pef.rank(ones[i] + 1)) << "at index " << i;
+	}
+
+	auto it = pef.iterator();
+	for (size_t i = 0; i < num_ones; i++) {
+		ASSERT_TRUE(it.hasNext());
+		ASSERT_EQ(i, it.nextIndex());
+		ASSERT_EQ(ones[i], it.next()) << "at index " << i;
+	}
+	ASSERT_FALSE(it.hasNext());
+
+	for (size_t from = 0; from < num_ones; from += 1 + next() % 1000) {
+		auto it = pef.iterator(from);
+		for (size_t i = from; i < std::min(num_ones, from + 2000); i++) ASSERT_EQ(ones[i], it.next()) << "at index " << i;
+	}
+
+	for (const uint64_t step : {UINT64_C(10), UINT64_C(1000), UINT64_C(100000)}) {
+		auto it2 = pef.iterator();
+		size_t consumed = 0;
+		for (uint64_t x = 0; x < num_bits + 10; x += 1 + next() % step) {
+			const auto lb = std::lower_bound(ones.begin() + consumed, ones.end(), x);
+			const uint64_t res = it2.nextGEQ(x);
+			if (lb == ones.end()) {
+				ASSERT_EQ(num_bits, res) << "for bound " << x;
+				ASSERT_FALSE(it2.hasNext());
+				break;
+			}
+			ASSERT_EQ(*lb, res) << "for bound " << x;
+			consumed = lb - ones.begin() + 1;
+			ASSERT_EQ(consumed, it2.nextIndex()) << "for bound " << x;
+		}
+	}
+}
+
+TEST(partitioned_elias_fano, corner_cases) {
+	run_partitioned_elias_fano({}, 1);
+	run_partitioned_elias_fano({0}, 1);
+	run_partitioned_elias_fano({5}, 100);
+	std::vector<uint64_t> ones(10000);
+	for (size_t i = 0; i < ones.size(); i++) ones[i] = i;
+	run_partitioned_elias_fano(ones, ones.size());
+	for (size_t i = 0; i < ones.size(); i++) ones[i] = 100 + i;
+	run_partitioned_elias_fano(ones, ones.size() + 200);
+}
+
+TEST(partitioned_elias_fano, clustered) {
+	for (const uint64_t max_gap : {UINT64_C(1), UINT64_C(3), UINT64_C(30), UINT64_C(1000)}) {
+		const auto ones = clustered_ones(50000, max_gap, 1000000);
+		run_partitioned_elias_fano(ones, ones.back() + 1 + next() % 100);
+	}
+}
+
+TEST(partitioned_elias_fano, space) {
+	using namespace sux::bits;
+	const auto ones = clustered_ones(1000000, 3, 10000000);
+	const uint64_t num_bits = ones.back() + 1;
+	PartitionedEliasFano pef(ones, num_bits);
+	EliasFano ef(ones, num_bits);
+	EXPECT_LT(pef.bitCount(), ef.bitCount());
+}
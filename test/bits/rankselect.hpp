@@ -1,11 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <fstream>
 #include <sux/bits/EliasFano.hpp>
+#include <sux/bits/InterleavedRankSel.hpp>
 #include <sux/bits/Rank9Sel.hpp>
+#include <sux/bits/RRR.hpp>
+#include <sux/bits/RankSmall.hpp>
 #include <sux/bits/SimpleSelect.hpp>
 #include <sux/bits/SimpleSelectHalf.hpp>
 #include <sux/bits/SimpleSelectZero.hpp>
 #include <sux/bits/SimpleSelectZeroHalf.hpp>
+#include <sux/util/Mapping.hpp>
+#include <vector>
 
 TEST(rankselect, all_ones) {
 	using namespace sux::bits;
@@ -18,11 +25,15 @@ TEST(rankselect, all_ones) {
 		EliasFano EliasFano(bitvect, size);
 		SimpleSelect SimpleSelect(bitvect, size, 3);
 		SimpleSelectHalf SimpleSelectHalf(bitvect, size);
+		InterleavedRankSel InterleavedRankSel(bitvect, size);
+		RankSmall RankSmall(bitvect, size);
 
 		// rank
 		for (size_t i = 0; i <= size; i++) {
 			EXPECT_EQ(i, Rank9Sel.rank(i)) << "at index " << i;
 			EXPECT_EQ(i, EliasFano.rank(i)) << "at index " << i;
+			EXPECT_EQ(i, InterleavedRankSel.rank(i)) << "at index " << i;
+			EXPECT_EQ(i, RankSmall.rank(i)) << "at index " << i;
 		}
 
 		// rankZero
@@ -37,6 +48,7 @@ TEST(rankselect, all_ones) {
 			EXPECT_EQ(i, EliasFano.select(i)) << "at index " << i;
 			EXPECT_EQ(i, SimpleSelect.select(i)) << "at index " << i;
 			EXPECT_EQ(i, SimpleSelectHalf.select(i)) << "at index " << i;
+			EXPECT_EQ(i, InterleavedRankSel.select(i)) << "at index " << i;
 		}
 
 		delete[] bitvect;
@@ -53,11 +65,15 @@ TEST(rankselect, all_zeroes) {
 		EliasFano EliasFano(bitvect, size);
 		SimpleSelectZero SimpleSelectZero(bitvect, size, 3);
 		SimpleSelectZeroHalf SimpleSelectZeroHalf(bitvect, size);
+		InterleavedRankSel InterleavedRankSel(bitvect, size);
+		RankSmall RankSmall(bitvect, size);
 
 		// rank
 		for (size_t i = 0; i <= size; i++) {
 			EXPECT_EQ(0, Rank9Sel.rank(i)) << "at index " << i;
 			EXPECT_EQ(0, EliasFano.rank(i)) << "at index " << i;
+			EXPECT_EQ(0, InterleavedRankSel.rank(i)) << "at index " << i;
+			EXPECT_EQ(0, RankSmall.rank(i)) << "at index " << i;
 		}
 
 		// rankZero
@@ -98,6 +114,8 @@ static void run_rankselect(std::size_t size) {
 	SimpleSelectZero SimpleSelectZero(bitvect, size,
 									  3); // TODO: try different LONGWORDS_PER_SUBINVENTORY
 	SimpleSelectZeroHalf SimpleSelectZeroHalf(bitvect, size);
+	InterleavedRankSel InterleavedRankSel(bitvect, size);
+	RankSmall RankSmall(bitvect, size);
 
 	// rank
 	for (size_t i = 0; i < ones; i++) {
@@ -105,6 +123,9 @@ static void run_rankselect(std::size_t size) {
 		EXPECT_EQ(pos, EliasFano.select(i));
 		EXPECT_EQ(i, Rank9Sel.rank(pos));
 		EXPECT_EQ(i, EliasFano.rank(pos));
+		EXPECT_EQ(i, InterleavedRankSel.rank(pos));
+		EXPECT_EQ(pos, InterleavedRankSel.select(i));
+		EXPECT_EQ(i, RankSmall.rank(pos));
 		pos = SimpleSelect.select(i);
 		EXPECT_EQ(i, Rank9Sel.rank(pos));
 		EXPECT_EQ(i, EliasFano.rank(pos));
@@ -118,6 +139,8 @@ static void run_rankselect(std::size_t size) {
 	for (size_t pos = 0; pos <= poslim; pos++) {
 		auto res = Rank9Sel.rank(pos);
 		EXPECT_EQ(res, EliasFano.rank(pos));
+		EXPECT_EQ(res, InterleavedRankSel.rank(pos));
+		EXPECT_EQ(res, RankSmall.rank(pos));
 		if (bitvect[pos / 64] & UINT64_C(1) << pos % 64)
 			EXPECT_EQ(pos, Rank9Sel.select(res));
 		else
@@ -133,6 +156,8 @@ static void run_rankselect(std::size_t size) {
 		EXPECT_EQ(pos, SimpleSelectZeroHalf.selectZero(i));
 		EXPECT_EQ(i, Rank9Sel.rankZero(pos));
 		EXPECT_EQ(i, EliasFano.rankZero(pos));
+		EXPECT_EQ(i, InterleavedRankSel.rankZero(pos));
+		EXPECT_EQ(i, RankSmall.rankZero(pos));
 	}
 
 	// selectZero
@@ -150,6 +175,29 @@ static void run_rankselect(std::size_t size) {
 	delete[] bitvect;
 }
 
+TEST(rankselect, interleaved_sparse) {
+	using namespace sux::bits;
+	// Clusters of ones separated by long runs of zeroes, so that selection must use binary search
+	const size_t size = 1 << 24;
+	std::vector<uint64_t> bitvect(size / 64 + 1);
+	std::vector<uint64_t> ones;
+	for (size_t p = 0; p < size; p += next() % 2 ? 1 : 1 + next() % 200000) {
+		bitvect[p / 64] |= UINT64_C(1) << p % 64;
+		ones.push_back(p);
+	}
+
+	InterleavedRankSel rs(bitvect.data(), size);
+	EXPECT_EQ(ones.size(), rs.rank(size));
+	for (size_t i = 0; i < ones.size(); i++) {
+		ASSERT_EQ(ones[i], rs.select(i)) << "at rank " << i;
+		ASSERT_EQ(i, rs.rank(ones[i])) << "at rank " << i;
+		ASSERT_EQ(i + 1, rs.rank(ones[i] + 1)) << "at rank " << i;
+	}
+
+	InterleavedRankSel empty(bitvect.data(), 0);
+	EXPECT_EQ(0, empty.rank(0));
+}
+
 TEST(rankselect, small_large) {
 	run_rankselect(10);
 	run_rankselect(64);
@@ -157,3 +205,352 @@ TEST(rankselect, small_large) {
 	run_rankselect(1024);
 	run_rankselect(512 * 1024);
 }
+
+static void run_elias_fano_iterator(const size_t num_ones, const uint64_t max_gap) {
+	using namespace sux::bits;
+	std::vector<uint64_t> ones(num_ones);
+	for (size_t i = 0; i < num_ones; i++) ones[i] = (i == 0 ? 0 : ones[i - 1] + 1) + next() % max_gap;
+	const uint64_t num_bits = num_ones == 0 ? 1 : ones[num_ones - 1] + 1 + next() % max_gap;
+	EliasFano ef(ones, num_bits);
+
+	for (size_t i = 0; i + 1 < num_ones; i++) {
+		uint64_t succ;
+		EXPECT_EQ(ones[i], ef.select(i, &succ)) << "at index " << i;
+		EXPECT_EQ(ones[i + 1], succ) << "at index " << i;
+	}
+
+	auto it = ef.iterator();
+	for (size_t i = 0; i < num_ones; i++) {
+		ASSERT_TRUE(it.hasNext());
+		ASSERT_EQ(i, it.nextIndex());
+		ASSERT_EQ(ones[i], it.next()) << "at index " << i;
+	}
+	ASSERT_FALSE(it.hasNext());
+
+	for (size_t from = 0; from < num_ones; from += 1 + next() % 1000) {
+		auto it = ef.iterator(from);
+		for (size_t i = from; i < std::min(num_ones, from + 100); i++) ASSERT_EQ(ones[i], it.next()) << "at index " << i;
+	}
+
+	// Increasing bounds with random skips, both short and long
+	auto it2 = ef.iterator();
+	size_t consumed = 0;
+	for (uint64_t x = 0; x < num_bits + 10; x += 1 + next() % (next() % 2 ? max_gap : 100 * max_gap)) {
+		const auto lb = std::lower_bound(ones.begin() + consumed, ones.end(), x);
+		const uint64_t res = it2.nextGEQ(x);
+		if (lb == ones.end()) {
+			ASSERT_EQ(num_bits, res) << "for bound " << x;
+			ASSERT_FALSE(it2.hasNext());
+			break;
+		}
+		ASSERT_EQ(*lb, res) << "for bound " << x;
+		consumed = lb - ones.begin() + 1;
+		ASSERT_EQ(consumed, it2.nextIndex()) << "for bound " << x;
+	}
+}
+
+TEST(rankselect, elias_fano_iterator) {
+	run_elias_fano_iterator(0, 10);
+	run_elias_fano_iterator(1, 10);
+	run_elias_fano_iterator(100000, 1);
+	run_elias_fano_iterator(100000, 3);
+	run_elias_fano_iterator(100000, 100);
+	run_elias_fano_iterator(10000, 100000);
+}
+
+static void run_batch(const size_t size) {
+	using namespace sux::bits;
+	const size_t words = size / 64 + 1;
+	std::vector<uint64_t> bitvect(words);
+	uint64_t ones = 0;
+	for (size_t i = 0; i < (size + 63) / 64; i++) {
+		bitvect[i] = next() & next();
+		if (i == (size + 63) / 64 - 1 && size % 64 != 0) bitvect[i] &= (UINT64_C(1) << size % 64) - 1;
+		ones += __builtin_popcountll(bitvect[i]);
+	}
+
+	Rank9Sel rank9sel(bitvect.data(), size);
+	EliasFano elias_fano(bitvect.data(), size);
+	SimpleSelect simple_select(bitvect.data(), size, 3);
+
+	// The batch length is not a multiple of the window, and queries are in random order
+	const size_t n = 1000;
+	std::vector<uint64_t> pos(n), rank(n), out(n);
+	for (size_t i = 0; i < n; i++) pos[i] = next() % (size + 1);
+
+	rank9sel.rank(pos.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) EXPECT_EQ(rank9sel.rank(pos[i]), out[i]) << "at position " << pos[i];
+	elias_fano.rank(pos.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) EXPECT_EQ(rank9sel.rank(pos[i]), out[i]) << "at position " << pos[i];
+
+	if (ones == 0) return;
+	for (size_t i = 0; i < n; i++) rank[i] = next() % ones;
+
+	rank9sel.select(rank.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) EXPECT_EQ(rank9sel.select(rank[i]), out[i]) << "at rank " << rank[i];
+	simple_select.select(rank.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) EXPECT_EQ(rank9sel.select(rank[i]), out[i]) << "at rank " << rank[i];
+	elias_fano.select(rank.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) EXPECT_EQ(rank9sel.select(rank[i]), out[i]) << "at rank " << rank[i];
+}
+
+TEST(rankselect, batch) {
+	run_batch(0);
+	run_batch(10);
+	run_batch(1000);
+	run_batch(1024 * 1024 + 1);
+}
+
+static void run_parallel_construction(const size_t size, const uint64_t density_mask, const int threads) {
+	using namespace sux::bits;
+	std::vector<uint64_t> bitvect(size / 64 + 1);
+	for (size_t i = 0; i < (size + 63) / 64; i++) {
+		bitvect[i] = next() & next() & (next() % 256 < density_mask ? -1ULL : 0);
+		if (i == (size + 63) / 64 - 1 && size % 64 != 0) bitvect[i] &= (UINT64_C(1) << size % 64) - 1;
+	}
+
+	Rank9Sel rank9sel(bitvect.data(), size);
+	const uint64_t ones = rank9sel.rank(size), zeros = size - ones;
+
+	Rank9Sel rank9sel_par(bitvect.data(), size, threads);
+	SimpleSelect simple_select(bitvect.data(), size, 3, threads);
+	SimpleSelectHalf simple_select_half(bitvect.data(), size, threads);
+	SimpleSelectZero simple_select_zero(bitvect.data(), size, 3, threads);
+	SimpleSelectZeroHalf simple_select_zero_half(bitvect.data(), size, threads);
+	SimpleSelectZero simple_select_zero_seq(bitvect.data(), size, 3);
+	EliasFano elias_fano(bitvect.data(), size, threads);
+	Rank9 rank9_par(bitvect.data(), size, threads);
+
+	for (uint64_t i = 0; i <= size; i++) ASSERT_EQ(rank9sel.rank(i), rank9_par.rank(i)) << "at position " << i << " with " << threads << " threads";
+
+	for (uint64_t i = 0; i < ones; i++) {
+		const uint64_t pos = rank9sel.select(i);
+		ASSERT_EQ(pos, rank9sel_par.select(i)) << "at rank " << i << " with " << threads << " threads";
+		ASSERT_EQ(pos, simple_select.select(i)) << "at rank " << i << " with " << threads << " threads";
+		ASSERT_EQ(pos, simple_select_half.select(i)) << "at rank " << i << " with " << threads << " threads";
+		ASSERT_EQ(pos, elias_fano.select(i)) << "at rank " << i << " with " << threads << " threads";
+		ASSERT_EQ(i, elias_fano.rank(pos)) << "at rank " << i << " with " << threads << " threads";
+	}
+
+	for (uint64_t i = 0; i < zeros; i++) {
+		const uint64_t pos = simple_select_zero_seq.selectZero(i);
+		ASSERT_EQ(pos, simple_select_zero.selectZero(i)) << "at rank " << i << " with " << threads << " threads";
+		ASSERT_EQ(pos, simple_select_zero_half.selectZero(i)) << "at rank " << i << " with " << threads << " threads";
+	}
+}
+
+TEST(rankselect, parallel_construction) {
+	for (int threads = 1; threads <= 8; threads++) {
+		run_parallel_construction(1, 256, threads);
+		run_parallel_construction(1000, 256, threads);
+		run_parallel_construction(1 << 20, 256, threads);
+		run_parallel_construction(1 << 20, 8, threads);
+		run_parallel_construction(3 << 20, 1, threads);
+	}
+}
+
+template <typename R9, typename R9S, typename SS, typename SSH, typename SSZ, typename SSZH, typename EF, typename IRS, typename RS>
+static void check_serialized(const std::vector<uint64_t> &bitvect, const size_t size, R9 &rank9, R9S &rank9sel, SS &simple_select, SSH &simple_select_half, SSZ &simple_select_zero,
+							 SSZH &simple_select_zero_half, EF &elias_fano, IRS &interleaved, RS &rank_small) {
+	uint64_t ones = 0;
+	for (size_t i = 0; i < size; i++) {
+		ASSERT_EQ(ones, rank9.rank(i)) << "at position " << i;
+		ASSERT_EQ(ones, rank9sel.rank(i)) << "at position " << i;
+		ASSERT_EQ(ones, elias_fano.rank(i)) << "at position " << i;
+		ASSERT_EQ(ones, interleaved.rank(i)) << "at position " << i;
+		ASSERT_EQ(ones, rank_small.rank(i)) << "at position " << i;
+		if (bitvect[i / 64] & UINT64_C(1) << i % 64) {
+			ASSERT_EQ(i, rank9sel.select(ones)) << "at rank " << ones;
+			ASSERT_EQ(i, simple_select.select(ones)) << "at rank " << ones;
+			ASSERT_EQ(i, simple_select_half.select(ones)) << "at rank " << ones;
+			ASSERT_EQ(i, elias_fano.select(ones)) << "at rank " << ones;
+			ASSERT_EQ(i, interleaved.select(ones)) << "at rank " << ones;
+			ones++;
+		} else {
+			ASSERT_EQ(i, simple_select_zero.selectZero(i - ones)) << "at rank " << i - ones;
+			ASSERT_EQ(i, simple_select_zero_half.selectZero(i - ones)) << "at rank " << i - ones;
+		}
+	}
+	ASSERT_EQ(ones, rank9.rank(size));
+	ASSERT_EQ(ones, rank9sel.rank(size));
+	ASSERT_EQ(ones, elias_fano.rank(size));
+	ASSERT_EQ(ones, interleaved.rank(size));
+	ASSERT_EQ(ones, rank_small.rank(size));
+}
+
+static void run_serialization(const size_t size, const uint64_t density_mask) {
+	using namespace sux::bits;
+	std::vector<uint64_t> bitvect(size / 64 + 1), copy;
+	for (size_t i = 0; i < (size + 63) / 64; i++) {
+		bitvect[i] = next() & next() & (next() % 256 < density_mask ? -1ULL : 0);
+		if (i == (size + 63) / 64 - 1 && size % 64 != 0) bitvect[i] &= (UINT64_C(1) << size % 64) - 1;
+	}
+	copy = bitvect;
+	const char *filename = "test/test_dump";
+
+	{
+		std::fstream fs;
+		fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+		fs.open(filename, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+		fs << Rank9(bitvect.data(), size) << Rank9Sel(bitvect.data(), size) << SimpleSelect(bitvect.data(), size, 3) << SimpleSelectHalf(bitvect.data(), size)
+		   << SimpleSelectZero(bitvect.data(), size, 3) << SimpleSelectZeroHalf(bitvect.data(), size) << EliasFano(bitvect.data(), size) << InterleavedRankSel(bitvect.data(), size)
+		   << RankSmall(bitvect.data(), size);
+		fs.close();
+	}
+
+	// Deserialized instances must not depend on the original bit vector
+	std::fill(bitvect.begin(), bitvect.end(), 0);
+
+	{
+		Rank9 rank9;
+		Rank9Sel rank9sel;
+		SimpleSelect simple_select;
+		SimpleSelectHalf simple_select_half;
+		SimpleSelectZero simple_select_zero;
+		SimpleSelectZeroHalf simple_select_zero_half;
+		EliasFano elias_fano;
+		InterleavedRankSel interleaved;
+		RankSmall rank_small;
+
+		std::fstream fs;
+		fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+		fs.open(filename, std::fstream::in | std::fstream::binary);
+		fs >> rank9 >> rank9sel >> simple_select >> simple_select_half >> simple_select_zero >> simple_select_zero_half >> elias_fano >> interleaved >> rank_small;
+		fs.close();
+
+		check_serialized(copy, size, rank9, rank9sel, simple_select, simple_select_half, simple_select_zero, simple_select_zero_half, elias_fano, interleaved, rank_small);
+	}
+
+	{
+		sux::util::Mapping mapping(filename);
+		Rank9 rank9(mapping);
+		Rank9Sel rank9sel(mapping);
+		SimpleSelect simple_select(mapping);
+		SimpleSelectHalf simple_select_half(mapping);
+		SimpleSelectZero simple_select_zero(mapping);
+		SimpleSelectZeroHalf simple_select_zero_half(mapping);
+		EliasFano elias_fano(mapping);
+		InterleavedRankSel interleaved(mapping);
+		RankSmall rank_small(mapping);
+
+		check_serialized(copy, size, rank9, rank9sel, simple_select, simple_select_half, simple_select_zero, simple_select_zero_half, elias_fano, interleaved, rank_small);
+	}
+
+	remove(filename);
+}
+
+TEST(rankselect, serialization) {
+	run_serialization(1, 256);
+	run_serialization(1000, 256);
+	run_serialization(1 << 20, 256);
+	run_serialization((1 << 20) + 1, 8);
+	run_serialization(3 << 20, 1);
+}
+
+template <sux::util::AllocType AT> static void run_owning(const size_t size, const uint64_t density_mask) {
+	using namespace sux::bits;
+	std::vector<uint64_t> bitvect((size + 63) / 64);
+	for (size_t i = 0; i < (size + 63) / 64; i++) {
+		bitvect[i] = next() & next() & (next() % 256 < density_mask ? -1ULL : 0);
+		if (i == (size + 63) / 64 - 1 && size % 64 != 0) bitvect[i] &= (UINT64_C(1) << size % 64) - 1;
+	}
+
+	// The vectors have no free word after the last one, and they are moved around after construction
+	std::vector<Rank9<AT>> rank9;
+	std::vector<Rank9Sel<AT>> rank9sel;
+	std::vector<RankSmall<AT>> rank_small;
+	std::vector<SimpleSelect<AT>> simple_select;
+	std::vector<SimpleSelectHalf<AT>> simple_select_half;
+	std::vector<SimpleSelectZero<AT>> simple_select_zero;
+	std::vector<SimpleSelectZeroHalf<AT>> simple_select_zero_half;
+	for (int i = 0; i < 2; i++) {
+		rank9.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size);
+		rank9sel.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size);
+		rank_small.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size);
+		simple_select.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size, 3);
+		simple_select_half.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size);
+		simple_select_zero.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size, 3);
+		simple_select_zero_half.emplace_back(sux::util::Vector<uint64_t, AT>(bitvect.data(), bitvect.size()), size);
+	}
+
+	for (int j = 0; j < 2; j++) {
+		uint64_t ones = 0;
+		for (size_t i = 0; i < size; i++) {
+			ASSERT_EQ(ones, rank9[j].rank(i)) << "at position " << i;
+			ASSERT_EQ(ones, rank9sel[j].rank(i)) << "at position " << i;
+			ASSERT_EQ(ones, rank_small[j].rank(i)) << "at position " << i;
+			if (bitvect[i / 64] & UINT64_C(1) << i % 64) {
+				ASSERT_EQ(i, rank9sel[j].select(ones)) << "at rank " << ones;
+				ASSERT_EQ(i, simple_select[j].select(ones)) << "at rank " << ones;
+				ASSERT_EQ(i, simple_select_half[j].select(ones)) << "at rank " << ones;
+				ones++;
+			} else {
+				ASSERT_EQ(i, simple_select_zero[j].selectZero(i - ones)) << "at rank " << i - ones;
+				ASSERT_EQ(i, simple_select_zero_half[j].selectZero(i - ones)) << "at rank " << i - ones;
+			}
+		}
+		ASSERT_EQ(ones, rank9[j].rank(size));
+		ASSERT_EQ(ones, rank9sel[j].rank(size));
+		ASSERT_EQ(ones, rank_small[j].rank(size));
+	}
+}
+
+TEST(rankselect, owning) {
+	run_owning<sux::util::AllocType::MALLOC>(64, 256);
+	run_owning<sux::util::AllocType::MALLOC>(1000, 256);
+	run_owning<sux::util::AllocType::MALLOC>(1 << 20, 8);
+	run_owning<sux::util::AllocType::SMALLPAGE>(1 << 16, 256);
+	run_owning<sux::util::AllocType::TRANSHUGEPAGE>(3 << 20, 1);
+}
+
+TEST(rankselect, select64) {
+	for (int i = 0; i < 100000; i++) {
+		const uint64_t x = next() & (i % 2 == 0 ? -1ULL : next());
+		if (x == 0) continue;
+		ASSERT_EQ(__builtin_popcountll(x), sux::nu(x));
+		for (uint64_t k = 0, pos = 0; k < (uint64_t)__builtin_popcountll(x); k++, pos++) {
+			while ((x & UINT64_C(1) << pos) == 0) pos++;
+			ASSERT_EQ(pos, sux::select64(x, k)) << "in " << x << " at rank " << k;
+			ASSERT_EQ(pos, sux::select64_broadword(x, k)) << "in " << x << " at rank " << k;
+		}
+	}
+}
+
+static void run_rrr(const size_t size, const uint64_t density_per_mille, const uint64_t run) {
+	using namespace sux::bits;
+	// Runs of random length and density, so that blocks of all classes and constant blocks appear
+	std::vector<uint64_t> bitvect(size / 64 + 1);
+	for (size_t p = 0; p < size;) {
+		const bool full = next() % 1000 < density_per_mille;
+		for (size_t e = std::min(size, p + 1 + next() % run); p < e; p++)
+			if (full ? next() % 8 != 0 : next() % 64 == 0) bitvect[p / 64] |= UINT64_C(1) << p % 64;
+	}
+
+	Rank9Sel rank9sel(bitvect.data(), size);
+	RRR rrr(bitvect.data(), size);
+	const uint64_t ones = rank9sel.rank(size);
+	ASSERT_EQ(size, rrr.size());
+	ASSERT_EQ(ones, rrr.numOnes());
+	for (size_t pos = 0; pos <= size; pos++) ASSERT_EQ(rank9sel.rank(pos), rrr.rank(pos)) << "at position " << pos;
+	for (uint64_t i = 0; i < ones; i++) ASSERT_EQ(rank9sel.select(i), rrr.select(i)) << "at rank " << i;
+
+	const char *filename = "test/test_dump";
+	std::fstream fs;
+	fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+	fs.open(filename, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	fs << rrr;
+	fs.close();
+	{
+		sux::util::Mapping mapping(filename);
+		RRR view(mapping);
+		for (size_t pos = 0; pos <= size; pos += 1 + next() % 64) ASSERT_EQ(rank9sel.rank(pos), view.rank(pos)) << "at position " << pos;
+		for (uint64_t i = 0; i < ones; i += 1 + next() % 64) ASSERT_EQ(rank9sel.select(i), view.select(i)) << "at rank " << i;
+	}
+	remove(filename);
+}
+
+TEST(rankselect, rrr) {
+	for (size_t size : {0, 1, 14, 15, 16, 479, 480, 481, 10000, 1 << 20})
+		for (uint64_t density : {0, 100, 500, 1000})
+			for (uint64_t run : {1, 100, 10000}) run_rrr(size, density, run);
+}
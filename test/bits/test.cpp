@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 
 #include "../xoroshiro128pp.hpp"
+#include "balancedparentheses.hpp"
 #include "dynranksel.hpp"
+#include "partitionedeliasfano.hpp"
 #include "rankselect.hpp"
+#include "waveletmatrix.hpp"
 #include <sux/util/FenwickBitF.hpp>
 #include <sux/util/FenwickBitL.hpp>
 #include <sux/util/FenwickByteF.hpp>
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <sux/bits/WaveletMatrix.hpp>
+#include <vector>
+
+static void run_wavelet_matrix(const std::vector<uint64_t> &seq, const int width, const int threads) {
+	using namespace sux::bits;
+	WaveletMatrix wm(seq, width, threads);
+	const size_t n = seq.size();
+	ASSERT_EQ(n, wm.size());
+
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(seq[i], wm.access(i)) << "at position " << i;
+
+	// Rank and select on some symbols occurring in the sequence, plus one that might not
+	std::vector<uint64_t> symbols(seq);
+	std::sort(symbols.begin(), symbols.end());
+	symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+	if (symbols.size() > 16) symbols.resize(16);
+	symbols.push_back(uint64_t(1) << (wm.getWidth() - 1) | 1);
+	for (const uint64_t c : symbols) {
+		uint64_t r = 0;
+		for (size_t i = 0; i < n; i++) {
+			ASSERT_EQ(r, wm.rank(c, i)) << "at position " << i << " for symbol " << c;
+			if (seq[i] == c) {
+				ASSERT_EQ(i, wm.select(c, r)) << "at rank " << r << " for symbol " << c;
+				r++;
+			}
+		}
+		ASSERT_EQ(r, wm.rank(c, n)) << "for symbol " << c;
+	}
+
+	for (int t = 0; t < 200 && n != 0; t++) {
+		const uint64_t from = next() % n, to = from + 1 + next() % (n - from);
+		std::vector<uint64_t> range(seq.begin() + from, seq.begin() + to);
+		std::sort(range.begin(), range.end());
+		for (uint64_t k = 0; k < range.size(); k += 1 + range.size() / 16) ASSERT_EQ(range[k], wm.quantile(from, to, k)) << "in [" << from << ".." << to << ") at rank " << k;
+
+		const uint64_t a = seq[from + next() % (to - from)], b = seq[from + next() % (to - from)];
+		const uint64_t min = std::min(a, b), max = std::max(a, b) + 1;
+		ASSERT_EQ((uint64_t)std::count_if(range.begin(), range.end(), [&](const uint64_t x) { return x >= min && x < max; }), wm.rangeCount(from, to, min, max));
+		ASSERT_EQ((uint64_t)std::count_if(range.begin(), range.end(), [&](const uint64_t x) { return x < min; }), wm.countLess(from, to, min));
+	}
+
+	std::vector<uint64_t> pos(n), c(n), out(n);
+	for (size_t i = 0; i < n; i++) {
+		pos[i] = next() % n;
+		c[i] = seq[next() % n];
+	}
+	wm.access(pos.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(seq[pos[i]], out[i]) << "at index " << i;
+	wm.rank(c.data(), pos.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(wm.rank(c[i], pos[i]), out[i]) << "at index " << i;
+}
+
+TEST(waveletmatrix, small) {
+	run_wavelet_matrix({}, 0, 1);
+	run_wavelet_matrix({0}, 0, 1);
+	run_wavelet_matrix({3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5}, 0, 1);
+	run_wavelet_matrix({3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5}, 10, 3);
+}
+
+TEST(waveletmatrix, random) {
+	for (int width : {1, 8, 16, 20}) {
+		std::vector<uint64_t> seq(10000);
+		for (auto &x : seq) x = next() & ((uint64_t(1) << width) - 1);
+		for (int threads = 1; threads <= 4; threads++) run_wavelet_matrix(seq, 0, threads);
+	}
+}
+
+TEST(waveletmatrix, skewed) {
+	// Mostly small symbols, with a few large ones
+	std::vector<uint64_t> seq(30000);
+	for (auto &x : seq) x = next() % 100 == 0 ? next() & ((uint64_t(1) << 40) - 1) : next() % 4;
+	run_wavelet_matrix(seq, 0, 2);
+	run_wavelet_matrix(seq, 64, 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sstream>
+#include <sux/function/DoubleEF.hpp>
+#include <vector>
+
+using namespace std;
+using namespace sux;
+using namespace sux::function;
+
+template <class EF> static void test_double_ef(const vector<uint64_t> &cum_keys, const vector<uint64_t> &position) {
+	EF ef(cum_keys, position);
+	stringstream ss;
+	ss << ef;
+	EF ef2;
+	ss >> ef2;
+
+	for (size_t i = 0; i < cum_keys.size() - 1; i++) {
+		uint64_t x, x2, y;
+		ef.get(i, x, x2, y);
+		ASSERT_EQ(cum_keys[i], x) << "at index " << i;
+		ASSERT_EQ(cum_keys[i + 1], x2) << "at index " << i;
+		ASSERT_EQ(position[i], y) << "at index " << i;
+		ef2.get(i, x, y);
+		ASSERT_EQ(cum_keys[i], x) << "at index " << i;
+		ASSERT_EQ(position[i], y) << "at index " << i;
+	}
+}
+
+template <class EF> static void test_double_ef(const size_t n) {
+	vector<uint64_t> cum_keys(n + 1), position(n + 1);
+	for (size_t i = 1; i <= n; i++) {
+		const uint64_t keys = 1 + next() % 2000;
+		cum_keys[i] = cum_keys[i - 1] + keys;
+		position[i] = position[i - 1] + keys * 2 + next() % 32;
+	}
+	test_double_ef<EF>(cum_keys, position);
+}
+
+TEST(double_ef_test, quantum) {
+	test_double_ef<DoubleEF<>>(100000);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 0, 2>>(10000);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 4, 4>>(10000);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 4, 10>>(100000);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 10, 20>>(100000);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 8, 14>>(10);
+}
+
+// Offsets in large superblocks do not fit into 16 bits
+TEST(double_ef_test, wide_offsets) {
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 4, 20>>(1 << 20);
+	test_double_ef<DoubleEF<util::AllocType::MALLOC, 8, 18>>(1 << 19);
+}
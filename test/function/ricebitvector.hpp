@@ -46,6 +46,12 @@ template <sux::util::AllocType AT = sux::util::AllocType::MALLOC> static void te
 			ASSERT_EQ(k, keys[i]) << "ERROR: " << k << " != " << keys[i] << endl;
 		}
 	}
+
+	vector<uint64_t> out(keys.size());
+	for (size_t t = 0; t < rice_test_ntrees; ++t) {
+		r.decodeAll(t * tree_offset, golomb_param, keys.size(), out.data());
+		ASSERT_EQ(keys, out);
+	}
 }
 
 TEST(RiceBitVector_test, trees_golomb_0) {
@@ -138,3 +144,45 @@ TEST(RiceBitVector_test, trees_golomb_6) {
 
 	test_rice_trees(r, keys, golomb_param, tree_offset);
 }
+
+TEST(RiceBitVector_test, append_bucket) {
+	static random_device rd;
+	static mt19937_64 rng(rd());
+	uniform_int_distribution<uint64_t> gen(0, 1000);
+	uniform_int_distribution<int> gen_log2golomb(0, 12);
+
+	typename RiceBitVector<>::Builder b, bb;
+	vector<vector<uint64_t>> buckets;
+	vector<vector<uint8_t>> log2golombs;
+	vector<size_t> bucket_pos;
+	for (size_t t = 0; t < 1000; ++t) {
+		vector<uint64_t> codes(1 + t % 100);
+		vector<uint8_t> log2golomb(codes.size());
+		vector<uint32_t> unary;
+		for (size_t i = 0; i < codes.size(); ++i) {
+			codes[i] = gen(rng);
+			log2golomb[i] = gen_log2golomb(rng);
+			b.appendFixed(codes[i], log2golomb[i]);
+			unary.push_back(codes[i] >> log2golomb[i]);
+		}
+		b.appendUnaryAll(unary);
+		bucket_pos.push_back(bb.getBits());
+		bb.appendBucket(codes.data(), log2golomb.data(), codes.size());
+		ASSERT_EQ(b.getBits(), bb.getBits());
+		buckets.push_back(codes);
+		log2golombs.push_back(log2golomb);
+	}
+
+	auto r = bb.build();
+	auto reader = r.reader();
+	for (size_t t = 0; t < buckets.size(); ++t) {
+		size_t fixed_len = 0;
+		for (auto l : log2golombs[t]) fixed_len += l;
+		reader.readReset(bucket_pos[t], fixed_len);
+		for (size_t i = 0; i < buckets[t].size(); ++i) ASSERT_EQ(buckets[t][i], reader.readNext(log2golombs[t][i]));
+
+		vector<uint64_t> out(buckets[t].size());
+		r.decodeAll(bucket_pos[t], log2golombs[t].data(), out.size(), out.data());
+		ASSERT_EQ(buckets[t], out);
+	}
+}
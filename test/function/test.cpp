@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "../xoroshiro128pp.hpp"
+#include "doubleef.hpp"
 #include "ricebitvector.hpp"
 
 #define LEAF 4
@@ -1,12 +1,20 @@
 #pragma once
 
 #include <cmath>
+#include <sstream>
+#include <sux/util/BAryPrefixSums.hpp>
+#include <sux/util/FenwickAtomicF.hpp>
+#include <sux/util/FenwickAtomicL.hpp>
 #include <sux/util/FenwickBitF.hpp>
 #include <sux/util/FenwickBitL.hpp>
 #include <sux/util/FenwickByteF.hpp>
 #include <sux/util/FenwickByteL.hpp>
 #include <sux/util/FenwickFixedF.hpp>
 #include <sux/util/FenwickFixedL.hpp>
+#include <sux/util/FenwickHybrid.hpp>
+#include <sux/util/StaticPrefixSums.hpp>
+#include <thread>
+#include <vector>
 
 template <std::size_t S> void run_fenwick(std::size_t size) {
 	using namespace sux::util;
@@ -25,6 +33,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 	FenwickByteL<S> bytel(increments, size);
 	FenwickBitF<S> bitf(increments, size);
 	FenwickBitL<S> bitl(increments, size);
+	FenwickHybrid<S, 1> hybrid1(increments, size);
+	FenwickHybrid<S, 3> hybrid3(increments, size);
+	BAryPrefixSums<S> bary(increments, size);
+	FenwickAtomicF<S> atomicf(increments, size);
+	FenwickAtomicL<S> atomicl(increments, size);
 
 	// prefix
 	for (size_t i = 0; i <= size; ++i) {
@@ -35,6 +48,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 		EXPECT_EQ(res, bytel.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitf.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitl.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid1.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid3.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, bary.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicf.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicl.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 	}
 
 	// find
@@ -47,6 +65,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 		EXPECT_EQ(res, bytel.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
 		EXPECT_EQ(res, bitf.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
 		EXPECT_EQ(res, bitl.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
+		EXPECT_EQ(res, hybrid1.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
+		EXPECT_EQ(res, hybrid3.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
+		EXPECT_EQ(res, bary.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
+		EXPECT_EQ(res, atomicf.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
+		EXPECT_EQ(res, atomicl.find(item)) << "at index " << i << ", size " << size << ", bound: " << S;
 	}
 
 	// add
@@ -57,6 +80,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 		bytel.add(i + 1, add_updates[i]);
 		bitf.add(i + 1, add_updates[i]);
 		bitl.add(i + 1, add_updates[i]);
+		hybrid1.add(i + 1, add_updates[i]);
+		hybrid3.add(i + 1, add_updates[i]);
+		bary.add(i + 1, add_updates[i]);
+		atomicf.add(i + 1, add_updates[i]);
+		atomicl.add(i + 1, add_updates[i]);
 	}
 
 	// post add prefix (check add correctness)
@@ -68,6 +96,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 		EXPECT_EQ(res, bytel.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitf.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitl.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid1.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid3.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, bary.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicf.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicl.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
 	}
 
 	// find complement
@@ -80,6 +113,11 @@ template <std::size_t S> void run_fenwick(std::size_t size) {
 		EXPECT_EQ(res, bytel.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitf.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
 		EXPECT_EQ(res, bitl.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid1.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, hybrid3.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, bary.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicf.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
+		EXPECT_EQ(res, atomicl.compFind(item)) << "at index " << i << ", size " << size << ", bound " << S;
 	}
 
 	delete[] increments;
@@ -119,3 +157,288 @@ TEST(fenwick, bound) {
 
 	// Note: BOUND >= 2^55 is not supported in FenwickBitF
 }
+
+template <std::size_t S, class SPS> void run_fenwick_push_pop(std::size_t size) {
+	using namespace sux::util;
+
+	FenwickFixedL<S> fixedl;
+	SPS sps;
+	for (std::size_t i = 0; i < size; i++) {
+		// Pops might leave stale data that must not affect later pushes
+		const std::uint64_t v = next() % (S + 1);
+		if (next() % 4 == 0) {
+			fixedl.push(S);
+			sps.push(S);
+			fixedl.pop();
+			sps.pop();
+		}
+		fixedl.push(v);
+		sps.push(v);
+	}
+	ASSERT_EQ(size, sps.size());
+
+	for (std::size_t i = 0; i <= size; i++) ASSERT_EQ(fixedl.prefix(i), sps.prefix(i)) << "at index " << i;
+	for (std::size_t i = 0; i <= size; i++) {
+		const std::uint64_t item = next() % (S * size + 1);
+		ASSERT_EQ(fixedl.find(item), sps.find(item)) << "at index " << i;
+		ASSERT_EQ(fixedl.compFind(item), sps.compFind(item)) << "at index " << i;
+	}
+	for (std::size_t i = 1; i <= size; i += 1 + next() % 16) {
+		if (fixedl.prefix(i) == fixedl.prefix(i - 1)) continue;
+		fixedl.add(i, -1);
+		sps.add(i, -1);
+	}
+	for (std::size_t i = 0; i <= size; i++) ASSERT_EQ(fixedl.prefix(i), sps.prefix(i)) << "at index " << i;
+
+	std::stringstream ss;
+	ss << sps;
+	SPS copy;
+	ss >> copy;
+	for (std::size_t i = 0; i <= size; i++) ASSERT_EQ(fixedl.prefix(i), copy.prefix(i)) << "at index " << i;
+}
+
+TEST(fenwick, push_pop) {
+	for (std::size_t size : {1, 100, 1023, 1024, 100000}) {
+		run_fenwick_push_pop<64, sux::util::FenwickFixedF<64>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickByteF<64>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickByteL<64>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickBitF<64>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickBitL<64>>(size);
+		run_fenwick_push_pop<1, sux::util::FenwickBitL<1>>(size);
+	}
+}
+
+TEST(fenwick, hybrid_push_pop) {
+	for (std::size_t size : {1, 100, 1023, 1024, 100000}) {
+		run_fenwick_push_pop<64, sux::util::FenwickHybrid<64, 1>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickHybrid<64, 4>>(size);
+		run_fenwick_push_pop<1000, sux::util::FenwickHybrid<1000, 10>>(size);
+		run_fenwick_push_pop<3, sux::util::FenwickHybrid<3, 64>>(size);
+	}
+}
+
+TEST(fenwick, atomic_push_pop) {
+	for (std::size_t size : {1, 100, 1023, 1024, 100000}) {
+		run_fenwick_push_pop<64, sux::util::FenwickAtomicF<64>>(size);
+		run_fenwick_push_pop<64, sux::util::FenwickAtomicL<64>>(size);
+	}
+}
+
+template <template <std::size_t, sux::util::AllocType> class FENWICK> void run_fenwick_concurrent(std::size_t size, int threads) {
+	constexpr std::size_t S = 64, UPDATES = 100000;
+	std::vector<std::uint64_t> sequence(size);
+	for (auto &x : sequence) x = next() % (S / 2 + 1);
+	FENWICK<S, sux::util::MALLOC> fenwick(sequence.data(), size);
+
+	// Each thread increments elements by one, at most S / 2 times per element in total
+	std::vector<std::vector<std::size_t>> idx(threads);
+	std::vector<std::uint64_t> increments(size);
+	for (int t = 0; t < threads; t++)
+		for (std::size_t i = 0; i < UPDATES; i++) {
+			const std::size_t j = next() % size;
+			if (increments[j] == S / 2) continue;
+			increments[j]++;
+			idx[t].push_back(j + 1);
+		}
+
+	std::vector<std::uint64_t> before(size + 1), after(size + 1);
+	for (std::size_t i = 0; i <= size; i++) before[i] = fenwick.prefix(i);
+	for (std::size_t i = 0; i < size; i++) sequence[i] += increments[i];
+	sux::util::FenwickFixedF<S> reference(sequence.data(), size);
+	for (std::size_t i = 0; i <= size; i++) after[i] = reference.prefix(i);
+
+	// Readers check that each prefix sum lies between the sums before and after the updates
+	std::vector<std::thread> pool;
+	std::vector<int> errors(threads);
+	for (int t = 0; t < threads; t++) {
+		pool.emplace_back([&, t] {
+			const std::int64_t one = 1;
+			for (std::size_t i = 0; i < idx[t].size(); i++) {
+				if (t % 2 == 0)
+					fenwick.add(idx[t][i], 1);
+				else
+					fenwick.addBatch(&idx[t][i], &one, 1);
+				const std::size_t length = (idx[t][i] * 7919) % (size + 1);
+				const std::uint64_t sum = fenwick.prefix(length);
+				if (sum < before[length] || sum > after[length]) errors[t]++;
+				if (fenwick.find(sum) > size) errors[t]++;
+			}
+		});
+	}
+	for (auto &thread : pool) thread.join();
+
+	for (int t = 0; t < threads; t++) EXPECT_EQ(0, errors[t]) << "in thread " << t;
+	for (std::size_t i = 0; i <= size; i++) ASSERT_EQ(after[i], fenwick.prefix(i)) << "at index " << i;
+	for (std::size_t i = 0; i < 1000; i++) {
+		const std::uint64_t val = next() % (after[size] + 1);
+		ASSERT_EQ(reference.find(val), fenwick.find(val));
+	}
+}
+
+TEST(fenwick, atomic_concurrent) {
+	for (std::size_t size : {1, 1000, 100000}) {
+		run_fenwick_concurrent<sux::util::FenwickAtomicF>(size, 4);
+		run_fenwick_concurrent<sux::util::FenwickAtomicL>(size, 4);
+	}
+}
+
+TEST(fenwick, bary_push_pop) {
+	for (std::size_t size : {1, 7, 8, 64, 100, 4096, 100000}) {
+		run_fenwick_push_pop<1, sux::util::BAryPrefixSums<1>>(size);
+		run_fenwick_push_pop<64, sux::util::BAryPrefixSums<64>>(size);
+		run_fenwick_push_pop<1000, sux::util::BAryPrefixSums<1000>>(size);
+	}
+}
+
+template <std::size_t S, template <std::size_t, sux::util::AllocType> class FENWICK> void run_fenwick_batch(std::size_t size, std::size_t n) {
+	std::vector<std::uint64_t> increments(size);
+	for (auto &x : increments) x = next() % (S / 2 + 1);
+
+	FENWICK<S, sux::util::MALLOC> fenwick(increments.data(), size), batch(increments.data(), size);
+
+	// Repeated indices and negative increments
+	std::vector<std::size_t> idx(n);
+	std::vector<std::int64_t> inc(n);
+	for (std::size_t i = 0; i < n; i++) {
+		idx[i] = 1 + next() % size;
+		const std::uint64_t v = increments[idx[i] - 1];
+		inc[i] = i % 2 == 0 ? std::int64_t(next() % (S - v + 1)) : -std::int64_t(next() % (v + 1));
+		increments[idx[i] - 1] += inc[i];
+		fenwick.add(idx[i], inc[i]);
+	}
+	batch.addBatch(idx.data(), inc.data(), n);
+
+	std::vector<std::size_t> length(n), out(n);
+	std::vector<std::uint64_t> sums(n), val(n), excess(n);
+	for (std::size_t i = 0; i < n; i++) length[i] = next() % (size + 1);
+	batch.prefixBatch(length.data(), sums.data(), n);
+	for (std::size_t i = 0; i < n; i++) ASSERT_EQ(fenwick.prefix(length[i]), sums[i]) << "at index " << i << ", size " << size;
+
+	for (std::size_t i = 0; i < n; i++) val[i] = excess[i] = next() % (S * size + 1);
+	batch.findBatch(val.data(), out.data(), n);
+	for (std::size_t i = 0; i < n; i++) {
+		ASSERT_EQ(fenwick.find(&excess[i]), out[i]) << "at index " << i << ", size " << size;
+		ASSERT_EQ(excess[i], val[i]) << "at index " << i << ", size " << size;
+	}
+}
+
+TEST(fenwick, batch) {
+	using namespace sux::util;
+	for (std::size_t size : {1, 2, 100, 1023, 1024, 100000}) {
+		for (std::size_t n : {0, 1, 15, 16, 1000}) {
+			run_fenwick_batch<64, FenwickFixedF>(size, n);
+			run_fenwick_batch<64, FenwickFixedL>(size, n);
+			run_fenwick_batch<64, FenwickByteF>(size, n);
+			run_fenwick_batch<64, FenwickByteL>(size, n);
+			run_fenwick_batch<64, FenwickBitF>(size, n);
+			run_fenwick_batch<64, FenwickBitL>(size, n);
+			run_fenwick_batch<64, FenwickHybridSplit<4>::type>(size, n);
+			run_fenwick_batch<64, BAryPrefixSums>(size, n);
+		}
+	}
+	run_fenwick_batch<1000, FenwickBitL>(100000, 100000);
+	run_fenwick_batch<1000, FenwickFixedF>(100000, 100000);
+}
+
+template <std::size_t S, template <std::size_t, sux::util::AllocType> class FENWICK> void run_fenwick_append(std::size_t size) {
+	std::vector<std::uint64_t> sequence(size);
+	for (auto &x : sequence) x = next() % (S + 1);
+
+	FENWICK<S, sux::util::MALLOC> pushed;
+	for (std::size_t i = 0; i < size; i++) pushed.push(sequence[i]);
+
+	const auto check = [&](FENWICK<S, sux::util::MALLOC> &fenwick) {
+		ASSERT_EQ(size, fenwick.size());
+		for (std::size_t i = 0; i <= size; i++) ASSERT_EQ(pushed.prefix(i), fenwick.prefix(i)) << "at index " << i << ", size " << size;
+		for (std::size_t i = 0; i < 1000; i++) {
+			const std::uint64_t item = next() % (S * size + 1);
+			ASSERT_EQ(pushed.find(item), fenwick.find(item)) << "at index " << i << ", size " << size;
+			ASSERT_EQ(pushed.compFind(item), fenwick.compFind(item)) << "at index " << i << ", size " << size;
+		}
+	};
+
+	for (int threads = 1; threads <= 4; threads++) {
+		FENWICK<S, sux::util::MALLOC> built(sequence.data(), size, threads);
+		check(built);
+	}
+
+	// Chunks of random length, with pops that might leave stale data behind
+	FENWICK<S, sux::util::MALLOC> appended;
+	for (std::size_t i = 0; i < size;) {
+		if (next() % 4 == 0) {
+			const std::size_t k = next() % (appended.size() + 1);
+			for (std::size_t j = 0; j < k; j++) appended.pop();
+			i -= k;
+		}
+		const std::size_t n = std::min<std::size_t>(size - i, next() % (size / 8 + 2));
+		appended.append(sequence.data() + i, n);
+		i += n;
+	}
+	check(appended);
+}
+
+TEST(fenwick, append) {
+	using namespace sux::util;
+	for (std::size_t size : {1, 2, 100, 1023, 1024, 100000, 300000}) {
+		run_fenwick_append<64, FenwickFixedF>(size);
+		run_fenwick_append<64, FenwickFixedL>(size);
+		run_fenwick_append<64, FenwickByteF>(size);
+		run_fenwick_append<64, FenwickByteL>(size);
+		run_fenwick_append<64, FenwickBitF>(size);
+		run_fenwick_append<64, FenwickBitL>(size);
+	}
+	run_fenwick_append<1, FenwickBitF>(300000);
+	run_fenwick_append<1, FenwickBitL>(300000);
+	run_fenwick_append<1000, FenwickByteL>(300000);
+}
+
+template <std::size_t S> void run_static_prefix_sums(std::size_t size) {
+	using namespace sux::util;
+
+	std::vector<uint64_t> increments(size);
+	for (auto &x : increments) x = next() % (S + 1);
+
+	FenwickFixedF<S> fixedf(increments.data(), size);
+	StaticPrefixSums<S> sps(increments.data(), size);
+	ASSERT_EQ(size, sps.size());
+
+	for (int round = 0; round < 2; round++) {
+		for (size_t i = 0; i <= sps.size(); ++i) ASSERT_EQ(fixedf.prefix(i), sps.prefix(i)) << "at index " << i << ", size " << size << ", bound " << S;
+
+		for (std::uint64_t i = 0; i <= sps.size() + 100; ++i) {
+			uint64_t item = next() % (S * (sps.size() + 2)), v0 = item, v1 = item;
+			ASSERT_EQ(fixedf.find(&v0), sps.find(&v1)) << "for " << item << ", size " << size << ", bound " << S;
+			ASSERT_EQ(v0, v1);
+			v0 = v1 = item;
+			ASSERT_EQ(fixedf.compFind(&v0), sps.compFind(&v1)) << "for " << item << ", size " << size << ", bound " << S;
+			ASSERT_EQ(v0, v1);
+		}
+
+		// Updates rebuild the structure
+		const size_t idx = 1 + next() % sps.size();
+		const int64_t inc = -int64_t(next() % (increments[idx - 1] + 1));
+		increments[idx - 1] += inc;
+		sps.add(idx, inc);
+		sps.push(S);
+		sps.pop();
+		increments.push_back(0);
+		sps.push(0);
+		fixedf = FenwickFixedF<S>(increments.data(), increments.size());
+	}
+	ASSERT_EQ(sps.size(), sps.find(UINT64_MAX));
+}
+
+TEST(fenwick, static_prefix_sums) {
+	sux::util::StaticPrefixSums<64> empty(nullptr, 0);
+	EXPECT_EQ(0, empty.prefix(0));
+	EXPECT_EQ(0, empty.find(10));
+	EXPECT_EQ(0, empty.compFind(10));
+	empty.push(5);
+	EXPECT_EQ(5, empty.prefix(1));
+
+	for (std::size_t size : {1, 2, 10, 1000, 100000}) {
+		run_static_prefix_sums<1>(size);
+		run_static_prefix_sums<64>(size);
+		run_static_prefix_sums<1000>(size);
+	}
+}
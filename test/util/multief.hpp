@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <sstream>
+#include <sux/util/MultiEF.hpp>
+#include <vector>
+
+template <class EF, size_t N> static void test_multi_ef(const std::array<std::vector<uint64_t>, N> &sequences) {
+	const size_t n = sequences[0].size();
+	EF ef(sequences);
+	ASSERT_EQ(n, ef.size());
+
+	std::stringstream ss;
+	ss << ef;
+	EF ef2;
+	ss >> ef2;
+	ASSERT_EQ(n, ef2.size());
+
+	uint64_t values[N], next;
+	for (size_t i = 0; i < n; i++) {
+		ef.get(i, values);
+		for (size_t j = 0; j < N; j++) ASSERT_EQ(sequences[j][i], values[j]) << "sequence " << j << ", index " << i;
+		const auto a = ef2.get(i);
+		for (size_t j = 0; j < N; j++) ASSERT_EQ(sequences[j][i], a[j]) << "sequence " << j << ", index " << i;
+		if (i < n - 1) {
+			ef.get(i, values, next);
+			for (size_t j = 0; j < N; j++) ASSERT_EQ(sequences[j][i], values[j]) << "sequence " << j << ", index " << i;
+			ASSERT_EQ(sequences[0][i + 1], next) << "index " << i;
+		}
+	}
+}
+
+template <class EF, size_t N> static void test_multi_ef(const size_t n, const std::array<uint64_t, N> &max_gap) {
+	std::array<std::vector<uint64_t>, N> sequences;
+	for (size_t j = 0; j < N; j++) {
+		sequences[j].resize(n);
+		for (size_t i = 0; i < n; i++) sequences[j][i] = (i == 0 ? 0 : sequences[j][i - 1]) + next() % (max_gap[j] + 1);
+	}
+	test_multi_ef<EF, N>(sequences);
+}
+
+TEST(multi_ef_test, one) {
+	using namespace sux::util;
+	test_multi_ef<MultiEF<1>, 1>(0, {10});
+	test_multi_ef<MultiEF<1>, 1>(1, {10});
+	test_multi_ef<MultiEF<1>, 1>(100000, {0});
+	test_multi_ef<MultiEF<1>, 1>(100000, {1000});
+	test_multi_ef<MultiEF<1, AllocType::MALLOC, 0, 2>, 1>(10000, {1000});
+}
+
+TEST(multi_ef_test, many) {
+	using namespace sux::util;
+	test_multi_ef<MultiEF<2>, 2>(100000, {10, 1000});
+	test_multi_ef<MultiEF<3>, 3>(100000, {1, 100, 10000});
+	test_multi_ef<MultiEF<3, AllocType::MALLOC, 4, 10>, 3>(100000, {1, 100, 10000});
+	test_multi_ef<MultiEF<4, AllocType::MALLOC, 10, 20>, 4>(100000, {0, 3, 300, 30000});
+}
+
+// Lower bits that do not fit into a single unaligned read, and offsets that do not fit into 16 bits
+TEST(multi_ef_test, wide) {
+	using namespace sux::util;
+	test_multi_ef<MultiEF<3>, 3>(10000, {UINT64_C(1) << 25, UINT64_C(1) << 20, UINT64_C(1) << 15});
+	test_multi_ef<MultiEF<2, AllocType::MALLOC, 4, 20>, 2>(1 << 20, {1, 100});
+}
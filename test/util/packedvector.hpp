@@ -0,0 +1,60 @@
+#pragma once
+
+#include <sstream>
+#include <sux/util/PackedVector.hpp>
+#include <vector>
+
+template <sux::util::AllocType AT> static void test_packed_vector(const int width, const size_t n) {
+	const uint64_t mask = width == 64 ? -1ULL : (UINT64_C(1) << width) - 1;
+	std::vector<uint64_t> values(n);
+	for (auto &v : values) v = next() & mask;
+
+	sux::util::PackedVector<AT> pv(width);
+	for (const auto v : values) pv.pushBack(v);
+	ASSERT_EQ(n, pv.size());
+	ASSERT_EQ(width, pv.getWidth());
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(values[i], pv.get(i)) << "at index " << i << ", width " << width;
+
+	for (size_t i = 0; i < n; i += 1 + next() % 8) {
+		values[i] = next() & mask;
+		pv.set(i, values[i]);
+	}
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(values[i], pv.get(i)) << "at index " << i << ", width " << width;
+
+	std::vector<uint64_t> out(n);
+	for (int t = 0; t < 20 && n != 0; t++) {
+		const size_t from = next() % n, to = from + next() % (n - from + 1);
+		pv.decode(from, to, out.data());
+		for (size_t i = from; i < to; i++) ASSERT_EQ(values[i], out[i - from]) << "at index " << i << ", width " << width;
+
+		for (size_t i = from; i < to; i++) values[i] = next() & mask;
+		pv.encode(from, values.data() + from, to - from);
+		for (size_t i = 0; i < n; i++) ASSERT_EQ(values[i], pv.get(i)) << "at index " << i << ", width " << width;
+	}
+	pv.decode(0, n, out.data());
+	ASSERT_EQ(values, out);
+
+	std::stringstream ss;
+	ss << pv;
+	sux::util::PackedVector<AT> pv2;
+	ss >> pv2;
+	ASSERT_EQ(n, pv2.size());
+	for (size_t i = 0; i < n; i++) ASSERT_EQ(values[i], pv2.get(i)) << "at index " << i << ", width " << width;
+
+	// Shrinking and growing again must yield zeros
+	pv.resize(n / 2);
+	pv.resize(n);
+	for (size_t i = n / 2; i < n; i++) ASSERT_EQ(0, pv.get(i)) << "at index " << i << ", width " << width;
+}
+
+TEST(packedvector, widths) {
+	for (int width = 0; width <= 64; width++)
+		for (size_t n : {0, 1, 7, 8, 17, 1000}) test_packed_vector<sux::util::AllocType::MALLOC>(width, n);
+}
+
+TEST(packedvector, alloc_types) {
+	for (int width : {1, 7, 13, 32, 33, 63}) {
+		test_packed_vector<sux::util::AllocType::SMALLPAGE>(width, 100000);
+		test_packed_vector<sux::util::AllocType::TRANSHUGEPAGE>(width, 100000);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sstream>
+#include <sux/util/RiceSequence.hpp>
+#include <vector>
+
+template <sux::util::AllocType AT> static void test_rice_sequence(const std::vector<uint64_t> &values, const int log2_sample) {
+	sux::util::RiceSequence<AT> rs(values, log2_sample);
+	ASSERT_EQ(values.size(), rs.size());
+
+	for (size_t i = 0; i < values.size(); i++) ASSERT_EQ(values[i], rs.get(i)) << "at index " << i;
+
+	auto it = rs.iterator();
+	for (size_t i = 0; i < values.size(); i++) {
+		ASSERT_TRUE(it.hasNext());
+		ASSERT_EQ(values[i], it.next()) << "at index " << i;
+	}
+	ASSERT_FALSE(it.hasNext());
+
+	for (size_t from = 0; from < values.size(); from += 1 + next() % 100) {
+		auto it = rs.iterator(from);
+		for (size_t i = from; i < std::min(values.size(), from + 200); i++) ASSERT_EQ(values[i], it.next()) << "at index " << i;
+	}
+
+	std::stringstream ss;
+	ss << rs;
+	sux::util::RiceSequence<AT> rs2;
+	ss >> rs2;
+	for (size_t i = 0; i < values.size(); i++) ASSERT_EQ(values[i], rs2.get(i)) << "at index " << i;
+}
+
+TEST(ricesequence, small_gaps) {
+	for (int log2_sample = 0; log2_sample < 8; log2_sample++) {
+		std::vector<uint64_t> values;
+		for (uint64_t i = 0, v = 0; i < 10000; i++) values.push_back(v += next() % 4);
+		test_rice_sequence<sux::util::AllocType::MALLOC>(values, log2_sample);
+	}
+}
+
+TEST(ricesequence, large_gaps) {
+	std::vector<uint64_t> values;
+	for (uint64_t i = 0, v = 0; i < 100000; i++) values.push_back(v += next() % 100000);
+	test_rice_sequence<sux::util::AllocType::MALLOC>(values, 6);
+	test_rice_sequence<sux::util::AllocType::MALLOC>(values, 4);
+}
+
+TEST(ricesequence, skewed_gaps) {
+	std::vector<uint64_t> values;
+	for (uint64_t i = 0, v = 0; i < 100000; i++) values.push_back(v += (i % 1000 == 0) ? next() % (1ULL << 40) : next() % 16);
+	test_rice_sequence<sux::util::AllocType::MALLOC>(values, 6);
+}
+
+TEST(ricesequence, corner_cases) {
+	test_rice_sequence<sux::util::AllocType::MALLOC>({}, 6);
+	test_rice_sequence<sux::util::AllocType::MALLOC>({42}, 6);
+	test_rice_sequence<sux::util::AllocType::MALLOC>(std::vector<uint64_t>(1000, 0), 6);
+	test_rice_sequence<sux::util::AllocType::MALLOC>(std::vector<uint64_t>(1000, 1ULL << 50), 6);
+}
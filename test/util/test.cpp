@@ -2,6 +2,9 @@
 
 #include "../xoroshiro128pp.hpp"
 #include "fenwick.hpp"
+#include "multief.hpp"
+#include "packedvector.hpp"
+#include "ricesequence.hpp"
 
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);